@@ -537,28 +537,39 @@ static void _run_coex(struct rtw89_dev *rtwdev,
 static void _write_scbd(struct rtw89_dev *rtwdev, u32 val, bool state);
 static void _update_bt_scbd(struct rtw89_dev *rtwdev, bool only_update);
 
-static void _send_fw_cmd(struct rtw89_dev *rtwdev, u8 h2c_class, u8 h2c_func,
-			 void *param, u16 len)
+static bool _chk_fw_cmd(struct rtw89_dev *rtwdev)
 {
 	struct rtw89_btc *btc = &rtwdev->btc;
 	struct rtw89_btc_btf_fwinfo *pfwinfo = &btc->fwinfo;
 	struct rtw89_btc_cx *cx = &btc->cx;
 	struct rtw89_btc_wl_info *wl = &cx->wl;
-	int ret;
 
 	if (!wl->status.map.init_ok) {
 		rtw89_debug(rtwdev, RTW89_DBG_BTC,
 			    "[BTC], %s(): return by btc not init!!\n", __func__);
 		pfwinfo->cnt_h2c_fail++;
-		return;
+		return false;
 	} else if ((wl->status.map.rf_off_pre == 1 && wl->status.map.rf_off == 1) ||
 		   (wl->status.map.lps_pre == 1 && wl->status.map.lps == 1)) {
 		rtw89_debug(rtwdev, RTW89_DBG_BTC,
 			    "[BTC], %s(): return by wl off!!\n", __func__);
 		pfwinfo->cnt_h2c_fail++;
-		return;
+		return false;
 	}
 
+	return true;
+}
+
+static void _send_fw_cmd(struct rtw89_dev *rtwdev, u8 h2c_class, u8 h2c_func,
+			 void *param, u16 len)
+{
+	struct rtw89_btc *btc = &rtwdev->btc;
+	struct rtw89_btc_btf_fwinfo *pfwinfo = &btc->fwinfo;
+	int ret;
+
+	if (!_chk_fw_cmd(rtwdev))
+		return;
+
 	pfwinfo->cnt_h2c++;
 
 	ret = rtw89_fw_h2c_raw_with_hdr(rtwdev, h2c_class, h2c_func, param, len,
@@ -567,6 +578,40 @@ static void _send_fw_cmd(struct rtw89_dev *rtwdev, u8 h2c_class, u8 h2c_func,
 		pfwinfo->cnt_h2c_fail++;
 }
 
+/* Get a zeroed H2C buffer of @len bytes to fill in place, or NULL if the
+ * command must not be sent now.
+ */
+static void *_get_fw_cmd(struct rtw89_dev *rtwdev, u16 len,
+			 struct sk_buff **skb)
+{
+	struct rtw89_btc_btf_fwinfo *pfwinfo = &rtwdev->btc.fwinfo;
+
+	if (!_chk_fw_cmd(rtwdev))
+		return NULL;
+
+	*skb = rtw89_fw_h2c_arena_alloc(rtwdev, len);
+	if (!*skb) {
+		pfwinfo->cnt_h2c_fail++;
+		return NULL;
+	}
+
+	return skb_put(*skb, len);
+}
+
+static void _send_fw_cmd_skb(struct rtw89_dev *rtwdev, u8 h2c_class,
+			     u8 h2c_func, struct sk_buff *skb)
+{
+	struct rtw89_btc_btf_fwinfo *pfwinfo = &rtwdev->btc.fwinfo;
+	int ret;
+
+	pfwinfo->cnt_h2c++;
+
+	ret = rtw89_fw_h2c_raw_skb_with_hdr(rtwdev, skb, h2c_class, h2c_func,
+					    false, true);
+	if (ret != 0)
+		pfwinfo->cnt_h2c_fail++;
+}
+
 static void _reset_btc_var(struct rtw89_dev *rtwdev, u8 type)
 {
 	struct rtw89_btc *btc = &rtwdev->btc;
@@ -1289,11 +1334,12 @@ static void rtw89_btc_fw_set_slots(struct rtw89_dev *rtwdev, u8 num,
 				   struct rtw89_btc_fbtc_slot *s)
 {
 	struct rtw89_btc_btf_set_slot_table *tbl = NULL;
+	struct sk_buff *skb;
 	u8 *ptr = NULL;
 	u16 n = 0;
 
 	n = sizeof(*s) * num + sizeof(*tbl);
-	tbl = kmalloc(n, GFP_KERNEL);
+	tbl = _get_fw_cmd(rtwdev, n, &skb);
 	if (!tbl)
 		return;
 
@@ -1302,9 +1348,7 @@ static void rtw89_btc_fw_set_slots(struct rtw89_dev *rtwdev, u8 num,
 	ptr = &tbl->buf[0];
 	memcpy(ptr, s, num * sizeof(*s));
 
-	_send_fw_cmd(rtwdev, BTFC_SET, SET_SLOT_TABLE, tbl, n);
-
-	kfree(tbl);
+	_send_fw_cmd_skb(rtwdev, BTFC_SET, SET_SLOT_TABLE, skb);
 }
 
 static void btc_fw_set_monreg(struct rtw89_dev *rtwdev)
@@ -3571,8 +3615,8 @@ static bool _chk_wl_rfk_request(struct rtw89_dev *rtwdev)
 	return false;
 }
 
-static
-void _run_coex(struct rtw89_dev *rtwdev, enum btc_reason_and_action reason)
+static void __run_coex(struct rtw89_dev *rtwdev,
+		       enum btc_reason_and_action reason)
 {
 	struct rtw89_btc *btc = &rtwdev->btc;
 	struct rtw89_btc_dm *dm = &rtwdev->btc.dm;
@@ -3722,6 +3766,15 @@ exit:
 	_action_common(rtwdev);
 }
 
+static
+void _run_coex(struct rtw89_dev *rtwdev, enum btc_reason_and_action reason)
+{
+	/* a coex run may update slots, policy and driver info in one go */
+	rtw89_fw_h2c_batch_begin(rtwdev);
+	__run_coex(rtwdev, reason);
+	rtw89_fw_h2c_batch_end(rtwdev);
+}
+
 void rtw89_btc_ntfy_poweron(struct rtw89_dev *rtwdev)
 {
 	struct rtw89_btc *btc = &rtwdev->btc;
@@ -3794,6 +3847,7 @@ void rtw89_btc_ntfy_init(struct rtw89_dev *rtwdev, u8 mode)
 		return;
 	}
 
+	rtw89_fw_h2c_batch_begin(rtwdev);
 	_write_scbd(rtwdev,
 		    BTC_WSCB_ACTIVE | BTC_WSCB_ON | BTC_WSCB_BTLOG, true);
 	_update_bt_scbd(rtwdev, true);
@@ -3812,6 +3866,7 @@ void rtw89_btc_ntfy_init(struct rtw89_dev *rtwdev, u8 mode)
 	_fw_set_drv_info(rtwdev, CXDRVINFO_CTRL);
 
 	_run_coex(rtwdev, BTC_RSN_NTFY_INIT);
+	rtw89_fw_h2c_batch_end(rtwdev);
 }
 
 void rtw89_btc_ntfy_scan_start(struct rtw89_dev *rtwdev, u8 phy_idx, u8 band)
@@ -3826,6 +3881,7 @@ void rtw89_btc_ntfy_scan_start(struct rtw89_dev *rtwdev, u8 phy_idx, u8 band)
 	wl->status.map.scan = true;
 	wl->scan_info.band[phy_idx] = band;
 	wl->scan_info.phy_map |= BIT(phy_idx);
+	rtw89_fw_h2c_batch_begin(rtwdev);
 	_fw_set_drv_info(rtwdev, CXDRVINFO_SCAN);
 
 	if (rtwdev->dbcc_en) {
@@ -3835,6 +3891,7 @@ void rtw89_btc_ntfy_scan_start(struct rtw89_dev *rtwdev, u8 phy_idx, u8 band)
 	}
 
 	_run_coex(rtwdev, BTC_RSN_NTFY_SCAN_START);
+	rtw89_fw_h2c_batch_end(rtwdev);
 }
 
 void rtw89_btc_ntfy_scan_finish(struct rtw89_dev *rtwdev, u8 phy_idx)
@@ -3848,6 +3905,7 @@ void rtw89_btc_ntfy_scan_finish(struct rtw89_dev *rtwdev, u8 phy_idx)
 
 	wl->status.map.scan = false;
 	wl->scan_info.phy_map &= ~BIT(phy_idx);
+	rtw89_fw_h2c_batch_begin(rtwdev);
 	_fw_set_drv_info(rtwdev, CXDRVINFO_SCAN);
 
 	if (rtwdev->dbcc_en) {
@@ -3856,6 +3914,7 @@ void rtw89_btc_ntfy_scan_finish(struct rtw89_dev *rtwdev, u8 phy_idx)
 	}
 
 	_run_coex(rtwdev, BTC_RSN_NTFY_SCAN_FINISH);
+	rtw89_fw_h2c_batch_end(rtwdev);
 }
 
 void rtw89_btc_ntfy_switch_band(struct rtw89_dev *rtwdev, u8 phy_idx, u8 band)
@@ -3870,6 +3929,7 @@ void rtw89_btc_ntfy_switch_band(struct rtw89_dev *rtwdev, u8 phy_idx, u8 band)
 
 	wl->scan_info.band[phy_idx] = band;
 	wl->scan_info.phy_map |= BIT(phy_idx);
+	rtw89_fw_h2c_batch_begin(rtwdev);
 	_fw_set_drv_info(rtwdev, CXDRVINFO_SCAN);
 
 	if (rtwdev->dbcc_en) {
@@ -3878,6 +3938,7 @@ void rtw89_btc_ntfy_switch_band(struct rtw89_dev *rtwdev, u8 phy_idx, u8 band)
 		_fw_set_drv_info(rtwdev, CXDRVINFO_DBCC);
 	}
 	_run_coex(rtwdev, BTC_RSN_NTFY_SWBAND);
+	rtw89_fw_h2c_batch_end(rtwdev);
 }
 
 void rtw89_btc_ntfy_specific_packet(struct rtw89_dev *rtwdev,
@@ -3944,46 +4005,54 @@ void rtw89_btc_ntfy_specific_packet(struct rtw89_dev *rtwdev,
 	_run_coex(rtwdev, BTC_RSN_NTFY_SPECIFIC_PACKET);
 }
 
-void rtw89_btc_ntfy_eapol_packet_work(struct work_struct *work)
+void rtw89_btc_ntfy_specific_packet_irqsafe(struct rtw89_dev *rtwdev,
+					    enum btc_pkt_type pkt_type)
 {
-	struct rtw89_dev *rtwdev = container_of(work, struct rtw89_dev,
-						btc.eapol_notify_work);
+	struct rtw89_btc *btc = &rtwdev->btc;
+	unsigned long delay = 0;
+	unsigned long last, next;
 
-	mutex_lock(&rtwdev->mutex);
-	rtw89_leave_ps_mode(rtwdev);
-	rtw89_btc_ntfy_specific_packet(rtwdev, PACKET_EAPOL);
-	mutex_unlock(&rtwdev->mutex);
-}
+	/* already pending, the worker will report it */
+	if (test_and_set_bit(pkt_type, &btc->spec_pkt_pending))
+		return;
 
-void rtw89_btc_ntfy_arp_packet_work(struct work_struct *work)
-{
-	struct rtw89_dev *rtwdev = container_of(work, struct rtw89_dev,
-						btc.arp_notify_work);
+	switch (pkt_type) {
+	case PACKET_EAPOL:
+	case PACKET_DHCP:
+		/* connecting state should reach coex without delay */
+		cancel_delayed_work(&btc->spec_pkt_notify_work);
+		break;
+	default:
+		last = READ_ONCE(btc->spec_pkt_last);
+		next = last + RTW89_COEX_SPEC_PKT_NTFY_PERIOD;
+		if (time_in_range_open(jiffies, last, next))
+			delay = next - jiffies;
+		break;
+	}
 
-	mutex_lock(&rtwdev->mutex);
-	rtw89_btc_ntfy_specific_packet(rtwdev, PACKET_ARP);
-	mutex_unlock(&rtwdev->mutex);
+	ieee80211_queue_delayed_work(rtwdev->hw, &btc->spec_pkt_notify_work,
+				     delay);
 }
 
-void rtw89_btc_ntfy_dhcp_packet_work(struct work_struct *work)
+void rtw89_btc_ntfy_specific_packet_work(struct work_struct *work)
 {
 	struct rtw89_dev *rtwdev = container_of(work, struct rtw89_dev,
-						btc.dhcp_notify_work);
+						btc.spec_pkt_notify_work.work);
+	struct rtw89_btc *btc = &rtwdev->btc;
+	unsigned long pending;
+	unsigned int pkt_type;
 
-	mutex_lock(&rtwdev->mutex);
-	rtw89_leave_ps_mode(rtwdev);
-	rtw89_btc_ntfy_specific_packet(rtwdev, PACKET_DHCP);
-	mutex_unlock(&rtwdev->mutex);
-}
+	pending = xchg(&btc->spec_pkt_pending, 0);
+	if (!pending)
+		return;
 
-void rtw89_btc_ntfy_icmp_packet_work(struct work_struct *work)
-{
-	struct rtw89_dev *rtwdev = container_of(work, struct rtw89_dev,
-						btc.icmp_notify_work);
+	WRITE_ONCE(btc->spec_pkt_last, jiffies);
 
 	mutex_lock(&rtwdev->mutex);
-	rtw89_leave_ps_mode(rtwdev);
-	rtw89_btc_ntfy_specific_packet(rtwdev, PACKET_ICMP);
+	if (pending & ~BIT(PACKET_ARP))
+		rtw89_leave_ps_mode(rtwdev);
+	for_each_set_bit(pkt_type, &pending, PACKET_MAX)
+		rtw89_btc_ntfy_specific_packet(rtwdev, pkt_type);
 	mutex_unlock(&rtwdev->mutex);
 }
 
@@ -4208,6 +4277,7 @@ void rtw89_btc_ntfy_role_info(struct rtw89_dev *rtwdev, struct rtw89_vif *rtwvif
 	wlinfo = &wl->link_info[r.pid];
 
 	memcpy(wlinfo, &r, sizeof(*wlinfo));
+	rtw89_fw_h2c_batch_begin(rtwdev);
 	_update_wl_info(rtwdev);
 
 	if (wlinfo->role == RTW89_WIFI_ROLE_STATION &&
@@ -4223,6 +4293,7 @@ void rtw89_btc_ntfy_role_info(struct rtw89_dev *rtwdev, struct rtw89_vif *rtwvif
 		wl->status.map._4way = false;
 
 	_run_coex(rtwdev, BTC_RSN_NTFY_ROLE_INFO);
+	rtw89_fw_h2c_batch_end(rtwdev);
 }
 
 void rtw89_btc_ntfy_radio_state(struct rtw89_dev *rtwdev, enum btc_rfctrl rf_state)
@@ -4323,6 +4394,11 @@ static bool _ntfy_wl_rfk(struct rtw89_dev *rtwdev, u8 phy_path,
 		    wl->rfk_info.state == BTC_WRFK_STOP)
 			_run_coex(rtwdev, BTC_RSN_NTFY_WL_RFK);
 
+		/* RFK starts right after this returns, so don't hold the
+		 * notification back in a batch of the caller.
+		 */
+		rtw89_fw_h2c_batch_flush(rtwdev);
+
 		if (wl->rfk_info.state == BTC_WRFK_START)
 			ieee80211_queue_delayed_work(rtwdev->hw,
 						     &rtwdev->coex_rfk_chk_work,
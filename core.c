@@ -23,6 +23,10 @@ static bool rtw89_disable_ps_mode;
 module_param_named(disable_ps_mode, rtw89_disable_ps_mode, bool, 0644);
 MODULE_PARM_DESC(disable_ps_mode, "Set Y to disable low power mode");
 
+static bool rtw89_shadow_regs_en;
+module_param_named(shadow_regs, rtw89_shadow_regs_en, bool, 0644);
+MODULE_PARM_DESC(shadow_regs, "Set Y to skip MMIO reads of driver owned registers in read-modify-writes");
+
 static struct ieee80211_channel rtw89_channels_2ghz[] = {
 	{ .center_freq = 2412, .hw_value = 1, },
 	{ .center_freq = 2417, .hw_value = 2, },
@@ -125,6 +129,8 @@ static void rtw89_traffic_stats_accu(struct rtw89_dev *rtwdev,
 				     struct sk_buff *skb, bool tx)
 {
 	struct ieee80211_hdr *hdr = (struct ieee80211_hdr *)skb->data;
+	struct rtw89_traffic_stats_pcpu *pcpu;
+	unsigned long flags;
 
 	if (!ieee80211_is_data(hdr->frame_control))
 		return;
@@ -133,15 +139,52 @@ static void rtw89_traffic_stats_accu(struct rtw89_dev *rtwdev,
 	    is_multicast_ether_addr(hdr->addr1))
 		return;
 
+	pcpu = get_cpu_ptr(stats->pcpu);
+	flags = u64_stats_update_begin_irqsave(&pcpu->syncp);
 	if (tx) {
-		stats->tx_cnt++;
-		stats->tx_unicast += skb->len;
+		u64_stats_inc(&pcpu->tx_cnt);
+		u64_stats_add(&pcpu->tx_unicast, skb->len);
 	} else {
-		stats->rx_cnt++;
-		stats->rx_unicast += skb->len;
+		u64_stats_inc(&pcpu->rx_cnt);
+		u64_stats_add(&pcpu->rx_unicast, skb->len);
 	}
+	u64_stats_update_end_irqrestore(&pcpu->syncp, flags);
+	put_cpu_ptr(stats->pcpu);
 }
 
+static void rtw89_tx_ll_stats_submit(struct rtw89_dev *rtwdev, bool eapol)
+{
+	struct rtw89_tx_ll_stats *stats;
+	unsigned long flags;
+
+	stats = get_cpu_ptr(rtwdev->tx_ll_stats);
+	flags = u64_stats_update_begin_irqsave(&stats->syncp);
+	if (eapol)
+		u64_stats_inc(&stats->eapol_cnt);
+	else
+		u64_stats_inc(&stats->mgmt_cnt);
+	u64_stats_update_end_irqrestore(&stats->syncp, flags);
+	put_cpu_ptr(rtwdev->tx_ll_stats);
+}
+
+void rtw89_tx_ll_stats_done(struct rtw89_dev *rtwdev, bool acked, u32 lat_us)
+{
+	struct rtw89_tx_ll_stats *stats;
+	unsigned long flags;
+
+	stats = get_cpu_ptr(rtwdev->tx_ll_stats);
+	flags = u64_stats_update_begin_irqsave(&stats->syncp);
+	if (acked)
+		u64_stats_inc(&stats->acked);
+	else
+		u64_stats_inc(&stats->failed);
+	u64_stats_add(&stats->lat_sum_us, lat_us);
+	stats->lat_max_us = max(stats->lat_max_us, lat_us);
+	u64_stats_update_end_irqrestore(&stats->syncp, flags);
+	put_cpu_ptr(rtwdev->tx_ll_stats);
+}
+EXPORT_SYMBOL(rtw89_tx_ll_stats_done);
+
 static void rtw89_get_channel_params(struct cfg80211_chan_def *chandef,
 				     struct rtw89_channel_params *chan_param)
 {
@@ -401,6 +444,9 @@ rtw89_core_tx_update_mgmt_info(struct rtw89_dev *rtwdev,
 	desc_info->dis_data_fb = true;
 	desc_info->data_rate = rtw89_core_get_mgmt_rate(rtwdev, tx_req);
 
+	if (!desc_info->hiq)
+		rtw89_tx_ll_stats_submit(rtwdev, false);
+
 	rtw89_debug(rtwdev, RTW89_DBG_TXRX,
 		    "tx mgmt frame with rate 0x%x on channel %d (bw %d)\n",
 		    desc_info->data_rate, rtwdev->hal.current_channel,
@@ -556,10 +602,19 @@ rtw89_core_tx_update_data_info(struct rtw89_dev *rtwdev,
 	struct sk_buff *skb = tx_req->skb;
 	u8 tid, tid_indicate;
 	u8 qsel, ch_dma;
+	bool port_ctrl;
 
 	tid = skb->priority & IEEE80211_QOS_CTL_TAG1D_MASK;
 	tid_indicate = rtw89_core_get_tid_indicate(rtwdev, tid);
-	qsel = desc_info->hiq ? RTW89_TX_QSEL_B0_HI : rtw89_core_get_qsel(rtwdev, tid);
+	port_ctrl = !!(IEEE80211_SKB_CB(skb)->control.flags &
+		       IEEE80211_TX_CTRL_PORT_CTRL_PROTO);
+	if (desc_info->hiq)
+		qsel = RTW89_TX_QSEL_B0_HI;
+	else if (port_ctrl)
+		/* keep handshakes off the AC rings, which can be deep */
+		qsel = RTW89_TX_QSEL_B0_MGMT;
+	else
+		qsel = rtw89_core_get_qsel(rtwdev, tid);
 	ch_dma = rtw89_core_get_ch_dma(rtwdev, qsel);
 
 	desc_info->ch_dma = ch_dma;
@@ -571,7 +626,9 @@ rtw89_core_tx_update_data_info(struct rtw89_dev *rtwdev,
 	/* enable wd_info for AMPDU */
 	desc_info->en_wd_info = true;
 
-	if (IEEE80211_SKB_CB(skb)->flags & IEEE80211_TX_CTL_AMPDU)
+	if (port_ctrl)
+		rtw89_tx_ll_stats_submit(rtwdev, true);
+	else if (IEEE80211_SKB_CB(skb)->flags & IEEE80211_TX_CTL_AMPDU)
 		rtw89_core_tx_update_ampdu_info(rtwdev, tx_req, tid);
 	if (IEEE80211_SKB_CB(skb)->control.hw_key)
 		rtw89_core_tx_update_sec_key(rtwdev, tx_req);
@@ -584,43 +641,53 @@ rtw89_core_tx_update_data_info(struct rtw89_dev *rtwdev,
 		desc_info->data_retry_lowest_rate = RTW89_HW_RATE_OFDM6;
 }
 
-static enum btc_pkt_type
-rtw89_core_tx_btc_spec_pkt_notify(struct rtw89_dev *rtwdev,
-				  struct rtw89_core_tx_request *tx_req)
+static enum btc_pkt_type rtw89_core_tx_get_btc_spec_pkt(struct sk_buff *skb)
 {
-	struct sk_buff *skb = tx_req->skb;
 	struct udphdr *udphdr;
 
-	if (IEEE80211_SKB_CB(skb)->control.flags & IEEE80211_TX_CTRL_PORT_CTRL_PROTO) {
-		ieee80211_queue_work(rtwdev->hw, &rtwdev->btc.eapol_notify_work);
+	if (IEEE80211_SKB_CB(skb)->control.flags & IEEE80211_TX_CTRL_PORT_CTRL_PROTO)
 		return PACKET_EAPOL;
-	}
 
-	if (skb->protocol == htons(ETH_P_ARP)) {
-		ieee80211_queue_work(rtwdev->hw, &rtwdev->btc.arp_notify_work);
+	if (skb->protocol == htons(ETH_P_ARP))
 		return PACKET_ARP;
-	}
 
 	if (skb->protocol == htons(ETH_P_IP) &&
 	    ip_hdr(skb)->protocol == IPPROTO_UDP) {
 		udphdr = udp_hdr(skb);
 		if (((udphdr->source == htons(67) && udphdr->dest == htons(68)) ||
 		     (udphdr->source == htons(68) && udphdr->dest == htons(67))) &&
-		    skb->len > 282) {
-			ieee80211_queue_work(rtwdev->hw, &rtwdev->btc.dhcp_notify_work);
+		    skb->len > 282)
 			return PACKET_DHCP;
-		}
 	}
 
 	if (skb->protocol == htons(ETH_P_IP) &&
-	    ip_hdr(skb)->protocol == IPPROTO_ICMP) {
-		ieee80211_queue_work(rtwdev->hw, &rtwdev->btc.icmp_notify_work);
+	    ip_hdr(skb)->protocol == IPPROTO_ICMP)
 		return PACKET_ICMP;
-	}
 
 	return PACKET_MAX;
 }
 
+static enum btc_pkt_type
+rtw89_core_tx_btc_spec_pkt_notify(struct rtw89_dev *rtwdev,
+				  struct rtw89_core_tx_request *tx_req)
+{
+	struct ieee80211_sta *sta = tx_req->sta;
+	struct sk_buff *skb = tx_req->skb;
+	enum btc_pkt_type pkt_type;
+	bool btc_wanted;
+
+	/* the type is needed by coex and by the HE HTC check only */
+	btc_wanted = rtw89_btc_ntfy_specific_packet_wanted(rtwdev);
+	if (!btc_wanted && (!sta || !sta->he_cap.has_he))
+		return PACKET_MAX;
+
+	pkt_type = rtw89_core_tx_get_btc_spec_pkt(skb);
+	if (btc_wanted && pkt_type != PACKET_MAX)
+		rtw89_btc_ntfy_specific_packet_irqsafe(rtwdev, pkt_type);
+
+	return pkt_type;
+}
+
 static void
 rtw89_core_tx_update_desc_info(struct rtw89_dev *rtwdev,
 			       struct rtw89_core_tx_request *tx_req)
@@ -672,11 +739,10 @@ void rtw89_core_tx_kick_off(struct rtw89_dev *rtwdev, u8 qsel)
 	rtw89_hci_tx_kick_off(rtwdev, ch_dma);
 }
 
-int rtw89_h2c_tx(struct rtw89_dev *rtwdev,
-		 struct sk_buff *skb, bool fwdl)
+static int __rtw89_h2c_tx(struct rtw89_dev *rtwdev,
+			  struct sk_buff *skb, bool fwdl)
 {
 	struct rtw89_core_tx_request tx_req = {0};
-	u32 cnt;
 	int ret;
 
 	tx_req.skb = skb;
@@ -686,20 +752,168 @@ int rtw89_h2c_tx(struct rtw89_dev *rtwdev,
 
 	rtw89_core_tx_update_desc_info(rtwdev, &tx_req);
 
-	if (!fwdl)
-		rtw89_hex_dump(rtwdev, RTW89_DBG_FW, "H2C: ", skb->data, skb->len);
-
-	cnt = rtw89_hci_check_and_reclaim_tx_resource(rtwdev, RTW89_TXCH_CH12);
-	if (cnt == 0) {
-		rtw89_err(rtwdev, "no tx fwcmd resource\n");
-		return -ENOSPC;
-	}
-
 	ret = rtw89_hci_tx_write(rtwdev, &tx_req);
 	if (ret) {
 		rtw89_err(rtwdev, "failed to transmit skb to HCI\n");
 		return ret;
 	}
+
+	return 0;
+}
+
+/* Write queued H2Cs in order for as long as CH12 has free BDs. Must be
+ * called with h2c_txq->lock held. Returns the number of H2Cs written.
+ */
+static u32 rtw89_h2c_txq_drain(struct rtw89_dev *rtwdev)
+{
+	struct rtw89_h2c_txq *h2c_txq = &rtwdev->fw.h2c_txq;
+	struct sk_buff *skb;
+	u32 sent = 0;
+
+	while ((skb = skb_peek(&h2c_txq->queue))) {
+		if (!rtw89_hci_check_and_reclaim_tx_resource(rtwdev,
+							     RTW89_TXCH_CH12))
+			break;
+
+		__skb_unlink(skb, &h2c_txq->queue);
+		if (__rtw89_h2c_tx(rtwdev, skb, false)) {
+			h2c_txq->dropped++;
+			dev_kfree_skb_any(skb);
+			continue;
+		}
+		sent++;
+	}
+
+	return sent;
+}
+
+void rtw89_core_h2c_txq_work(struct work_struct *work)
+{
+	struct rtw89_dev *rtwdev = container_of(work, struct rtw89_dev,
+						fw.h2c_txq.work.work);
+	struct rtw89_h2c_txq *h2c_txq = &rtwdev->fw.h2c_txq;
+	bool pending;
+	u32 sent;
+
+	mutex_lock(&rtwdev->mutex);
+
+	/* stopped or powered off: nothing can be sent, and CH12 would never
+	 * get credit back, so drop the queue rather than retry forever
+	 */
+	if (!test_bit(RTW89_FLAG_RUNNING, rtwdev->flags) ||
+	    !test_bit(RTW89_FLAG_POWERON, rtwdev->flags)) {
+		rtw89_core_h2c_txq_purge(rtwdev);
+		goto out;
+	}
+
+	/* like every synchronous sender, keep the chip out of LPS while the
+	 * FWCMD doorbell is rung
+	 */
+	rtw89_leave_ps_mode(rtwdev);
+
+	spin_lock_bh(&h2c_txq->lock);
+	sent = rtw89_h2c_txq_drain(rtwdev);
+	pending = !skb_queue_empty(&h2c_txq->queue);
+	spin_unlock_bh(&h2c_txq->lock);
+
+	if (sent)
+		rtw89_hci_tx_kick_off(rtwdev, RTW89_TXCH_CH12);
+	if (pending)
+		ieee80211_queue_delayed_work(rtwdev->hw, &h2c_txq->work,
+					     RTW89_H2C_TXQ_RETRY_PERIOD);
+out:
+	mutex_unlock(&rtwdev->mutex);
+}
+
+/* Send what CH12 has credit for now and ring the doorbell. A sender about
+ * to wait for firmware calls this itself, since the queue work needs the
+ * mutex that sender may hold. Returns whether H2Cs are still queued.
+ */
+bool rtw89_core_h2c_txq_flush(struct rtw89_dev *rtwdev)
+{
+	struct rtw89_h2c_txq *h2c_txq = &rtwdev->fw.h2c_txq;
+	bool pending;
+	u32 sent;
+
+	spin_lock_bh(&h2c_txq->lock);
+	sent = rtw89_h2c_txq_drain(rtwdev);
+	pending = !skb_queue_empty(&h2c_txq->queue);
+	spin_unlock_bh(&h2c_txq->lock);
+
+	if (sent)
+		rtw89_hci_tx_kick_off(rtwdev, RTW89_TXCH_CH12);
+
+	return pending;
+}
+
+/* Write a firmware download chunk to CH12 without ringing the doorbell. The
+ * caller makes sure CH12 has credit and kicks it once per batch of chunks.
+ */
+int rtw89_h2c_tx_fwdl(struct rtw89_dev *rtwdev, struct sk_buff *skb)
+{
+	return __rtw89_h2c_tx(rtwdev, skb, true);
+}
+
+void rtw89_core_h2c_txq_purge(struct rtw89_dev *rtwdev)
+{
+	struct rtw89_h2c_txq *h2c_txq = &rtwdev->fw.h2c_txq;
+
+	spin_lock_bh(&h2c_txq->lock);
+	__skb_queue_purge(&h2c_txq->queue);
+	spin_unlock_bh(&h2c_txq->lock);
+}
+
+int rtw89_h2c_tx(struct rtw89_dev *rtwdev,
+		 struct sk_buff *skb, bool fwdl)
+{
+	struct rtw89_h2c_txq *h2c_txq = &rtwdev->fw.h2c_txq;
+	bool pending;
+	u32 depth;
+	u32 sent;
+	u32 cnt;
+	int ret;
+
+	if (fwdl) {
+		cnt = rtw89_hci_check_and_reclaim_tx_resource(rtwdev,
+							      RTW89_TXCH_CH12);
+		if (cnt == 0) {
+			rtw89_err(rtwdev, "no tx fwcmd resource\n");
+			return -ENOSPC;
+		}
+
+		ret = __rtw89_h2c_tx(rtwdev, skb, true);
+		if (ret)
+			return ret;
+
+		rtw89_hci_tx_kick_off(rtwdev, RTW89_TXCH_CH12);
+		return 0;
+	}
+
+	rtw89_hex_dump(rtwdev, RTW89_DBG_FW, "H2C: ", skb->data, skb->len);
+
+	/* The skb is owned by the queue from here on; it is sent once CH12
+	 * has credit, behind anything that is already waiting.
+	 */
+	spin_lock_bh(&h2c_txq->lock);
+	__skb_queue_tail(&h2c_txq->queue, skb);
+	sent = rtw89_h2c_txq_drain(rtwdev);
+	depth = skb_queue_len(&h2c_txq->queue);
+	pending = depth != 0;
+	if (pending) {
+		if (depth == 1)
+			h2c_txq->stalls++;
+		h2c_txq->queued++;
+		h2c_txq->max_depth = max(h2c_txq->max_depth, depth);
+	}
+	spin_unlock_bh(&h2c_txq->lock);
+
+	if (pending && !delayed_work_pending(&h2c_txq->work))
+		ieee80211_queue_delayed_work(rtwdev->hw, &h2c_txq->work,
+					     RTW89_H2C_TXQ_RETRY_PERIOD);
+
+	if (!sent || rtw89_fw_h2c_batch_defer_kick(rtwdev))
+		return 0;
+
 	rtw89_hci_tx_kick_off(rtwdev, RTW89_TXCH_CH12);
 
 	return 0;
@@ -710,6 +924,7 @@ int rtw89_core_tx_write(struct rtw89_dev *rtwdev, struct ieee80211_vif *vif,
 {
 	struct rtw89_core_tx_request tx_req = {0};
 	struct rtw89_vif *rtwvif = (struct rtw89_vif *)vif->drv_priv;
+	u8 ac;
 	int ret;
 
 	tx_req.skb = skb;
@@ -720,7 +935,14 @@ int rtw89_core_tx_write(struct rtw89_dev *rtwdev, struct ieee80211_vif *vif,
 	rtw89_traffic_stats_accu(rtwdev, &rtwvif->stats, skb, true);
 	rtw89_core_tx_update_desc_info(rtwdev, &tx_req);
 	ret = rtw89_hci_tx_write(rtwdev, &tx_req);
-	if (ret) {
+	if (ret == -ENOSPC) {
+		ac = rtw89_core_get_ac_by_ch_dma(tx_req.desc_info.ch_dma);
+		if (ac < IEEE80211_NUM_ACS)
+			rtwdev->tx_flow.drop_cnt[ac]++;
+		rtw89_debug(rtwdev, RTW89_DBG_TXRX, "no tx resource of ch %d\n",
+			    tx_req.desc_info.ch_dma);
+		return ret;
+	} else if (ret) {
 		rtw89_err(rtwdev, "failed to transmit skb to HCI\n");
 		return ret;
 	}
@@ -1420,6 +1642,38 @@ void rtw89_core_rx(struct rtw89_dev *rtwdev,
 }
 EXPORT_SYMBOL(rtw89_core_rx);
 
+void rtw89_core_stop_tx_ch(struct rtw89_dev *rtwdev, u8 ch_dma)
+{
+	struct rtw89_tx_flow *tx_flow = &rtwdev->tx_flow;
+	u8 ac = rtw89_core_get_ac_by_ch_dma(ch_dma);
+
+	if (ac >= IEEE80211_NUM_ACS)
+		return;
+
+	if (test_and_set_bit(ac, &tx_flow->stopped))
+		return;
+
+	tx_flow->stop_cnt[ac]++;
+	ieee80211_stop_queue(rtwdev->hw, ac);
+}
+EXPORT_SYMBOL(rtw89_core_stop_tx_ch);
+
+void rtw89_core_wake_tx_ch(struct rtw89_dev *rtwdev, u8 ch_dma)
+{
+	struct rtw89_tx_flow *tx_flow = &rtwdev->tx_flow;
+	u8 ac = rtw89_core_get_ac_by_ch_dma(ch_dma);
+
+	if (ac >= IEEE80211_NUM_ACS)
+		return;
+
+	if (!test_and_clear_bit(ac, &tx_flow->stopped))
+		return;
+
+	tx_flow->wake_cnt[ac]++;
+	ieee80211_wake_queue(rtwdev->hw, ac);
+}
+EXPORT_SYMBOL(rtw89_core_wake_tx_ch);
+
 void rtw89_core_napi_start(struct rtw89_dev *rtwdev)
 {
 	if (test_and_set_bit(RTW89_FLAG_NAPI_RUNNING, rtwdev->flags))
@@ -1552,7 +1806,7 @@ static void rtw89_core_txq_push(struct rtw89_dev *rtwdev,
 	struct ieee80211_sta *sta = txq->sta;
 	struct sk_buff *skb;
 	unsigned long i;
-	int ret;
+	int ret, qsel;
 
 	for (i = 0; i < frame_cnt; i++) {
 		skb = ieee80211_tx_dequeue_ni(rtwdev->hw, txq);
@@ -1561,12 +1815,19 @@ static void rtw89_core_txq_push(struct rtw89_dev *rtwdev,
 			return;
 		}
 		rtw89_core_txq_check_agg(rtwdev, rtwtxq, skb);
-		ret = rtw89_core_tx_write(rtwdev, vif, sta, skb, NULL);
+		ret = rtw89_core_tx_write(rtwdev, vif, sta, skb, &qsel);
 		if (ret) {
-			rtw89_err(rtwdev, "failed to push txq: %d\n", ret);
+			if (ret != -ENOSPC)
+				rtw89_err(rtwdev, "failed to push txq: %d\n", ret);
 			ieee80211_free_txskb(rtwdev->hw, skb);
 			break;
 		}
+
+		/* port control frames go to the MGMT channel, don't let them
+		 * wait for the kick off of the AC batch
+		 */
+		if (qsel == RTW89_TX_QSEL_B0_MGMT)
+			rtw89_core_tx_kick_off(rtwdev, qsel);
 	}
 }
 
@@ -1680,12 +1941,50 @@ static enum rtw89_tfc_lv rtw89_get_traffic_level(struct rtw89_dev *rtwdev,
 	return RTW89_TFC_ULTRA_LOW;
 }
 
+static void rtw89_traffic_stats_fold(struct rtw89_traffic_stats *stats)
+{
+	const struct rtw89_traffic_stats_pcpu *pcpu;
+	u64 tx_unicast = 0, rx_unicast = 0, tx_cnt = 0, rx_cnt = 0;
+	u64 tx_bytes, rx_bytes, tx_pkts, rx_pkts;
+	unsigned int start;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		pcpu = per_cpu_ptr(stats->pcpu, cpu);
+		do {
+			start = u64_stats_fetch_begin(&pcpu->syncp);
+			tx_bytes = u64_stats_read(&pcpu->tx_unicast);
+			rx_bytes = u64_stats_read(&pcpu->rx_unicast);
+			tx_pkts = u64_stats_read(&pcpu->tx_cnt);
+			rx_pkts = u64_stats_read(&pcpu->rx_cnt);
+		} while (u64_stats_fetch_retry(&pcpu->syncp, start));
+
+		tx_unicast += tx_bytes;
+		rx_unicast += rx_bytes;
+		tx_cnt += tx_pkts;
+		rx_cnt += rx_pkts;
+	}
+
+	/* pcpu counters are never reset, so report the delta of this period */
+	stats->tx_unicast = tx_unicast - stats->tx_unicast_folded;
+	stats->rx_unicast = rx_unicast - stats->rx_unicast_folded;
+	stats->tx_cnt = tx_cnt - stats->tx_cnt_folded;
+	stats->rx_cnt = rx_cnt - stats->rx_cnt_folded;
+
+	stats->tx_unicast_folded = tx_unicast;
+	stats->rx_unicast_folded = rx_unicast;
+	stats->tx_cnt_folded = tx_cnt;
+	stats->rx_cnt_folded = rx_cnt;
+}
+
 static bool rtw89_traffic_stats_calc(struct rtw89_dev *rtwdev,
 				     struct rtw89_traffic_stats *stats)
 {
 	enum rtw89_tfc_lv tx_tfc_lv = stats->tx_tfc_lv;
 	enum rtw89_tfc_lv rx_tfc_lv = stats->rx_tfc_lv;
 
+	rtw89_traffic_stats_fold(stats);
+
 	stats->tx_throughput_raw = (u32)(stats->tx_unicast >> RTW89_TP_SHIFT);
 	stats->rx_throughput_raw = (u32)(stats->rx_unicast >> RTW89_TP_SHIFT);
 
@@ -1703,11 +2002,6 @@ static bool rtw89_traffic_stats_calc(struct rtw89_dev *rtwdev,
 	stats->rx_avg_len = stats->rx_cnt ?
 			    DIV_ROUND_DOWN_ULL(stats->rx_unicast, stats->rx_cnt) : 0;
 
-	stats->tx_unicast = 0;
-	stats->rx_unicast = 0;
-	stats->tx_cnt = 0;
-	stats->rx_cnt = 0;
-
 	if (tx_tfc_lv != stats->tx_tfc_lv || rx_tfc_lv != stats->rx_tfc_lv)
 		return true;
 
@@ -1744,15 +2038,60 @@ static void rtw89_enter_lps_track(struct rtw89_dev *rtwdev)
 		rtw89_vif_enter_lps(rtwdev, rtwvif);
 }
 
-void rtw89_traffic_stats_init(struct rtw89_dev *rtwdev,
-			      struct rtw89_traffic_stats *stats)
+int rtw89_traffic_stats_init(struct rtw89_dev *rtwdev,
+			     struct rtw89_traffic_stats *stats)
 {
+	struct rtw89_traffic_stats_pcpu *pcpu;
+	int cpu;
+
+	/* keep the pcpu storage if mac80211 re-adds the vif on restart */
+	if (!stats->pcpu) {
+		stats->pcpu = alloc_percpu(struct rtw89_traffic_stats_pcpu);
+		if (!stats->pcpu)
+			return -ENOMEM;
+
+		for_each_possible_cpu(cpu) {
+			pcpu = per_cpu_ptr(stats->pcpu, cpu);
+			u64_stats_init(&pcpu->syncp);
+		}
+	}
+
+	rtw89_traffic_stats_fold(stats);
 	stats->tx_unicast = 0;
 	stats->rx_unicast = 0;
 	stats->tx_cnt = 0;
 	stats->rx_cnt = 0;
 	ewma_tp_init(&stats->tx_ewma_tp);
 	ewma_tp_init(&stats->rx_ewma_tp);
+
+	return 0;
+}
+
+void rtw89_traffic_stats_deinit(struct rtw89_dev *rtwdev,
+				struct rtw89_traffic_stats *stats)
+{
+	free_percpu(stats->pcpu);
+	stats->pcpu = NULL;
+}
+
+static int rtw89_tx_ll_stats_init(struct rtw89_dev *rtwdev)
+{
+	int cpu;
+
+	rtwdev->tx_ll_stats = alloc_percpu(struct rtw89_tx_ll_stats);
+	if (!rtwdev->tx_ll_stats)
+		return -ENOMEM;
+
+	for_each_possible_cpu(cpu)
+		u64_stats_init(&per_cpu_ptr(rtwdev->tx_ll_stats, cpu)->syncp);
+
+	return 0;
+}
+
+static void rtw89_tx_ll_stats_deinit(struct rtw89_dev *rtwdev)
+{
+	free_percpu(rtwdev->tx_ll_stats);
+	rtwdev->tx_ll_stats = NULL;
 }
 
 static void rtw89_track_work(struct work_struct *work)
@@ -2352,14 +2691,15 @@ void rtw89_core_update_beacon_work(struct work_struct *work)
 {
 	struct rtw89_dev *rtwdev;
 	struct rtw89_vif *rtwvif = container_of(work, struct rtw89_vif,
-						update_beacon_work);
+						update_beacon_work.work);
 
 	if (rtwvif->net_type != RTW89_NET_TYPE_AP_MODE)
 		return;
 
 	rtwdev = rtwvif->rtwdev;
 	mutex_lock(&rtwdev->mutex);
-	rtw89_fw_h2c_update_beacon(rtwdev, rtwvif);
+	if (test_bit(RTW89_FLAG_RUNNING, rtwdev->flags))
+		rtw89_fw_h2c_update_beacon(rtwdev, rtwvif);
 	mutex_unlock(&rtwdev->mutex);
 }
 
@@ -2411,6 +2751,7 @@ int rtw89_core_start(struct rtw89_dev *rtwdev)
 void rtw89_core_stop(struct rtw89_dev *rtwdev)
 {
 	struct rtw89_btc *btc = &rtwdev->btc;
+	struct rtw89_vif *rtwvif;
 
 	/* Prvent to stop twice; enter_ips and ops_stop */
 	if (!test_bit(RTW89_FLAG_RUNNING, rtwdev->flags))
@@ -2420,13 +2761,19 @@ void rtw89_core_stop(struct rtw89_dev *rtwdev)
 
 	clear_bit(RTW89_FLAG_RUNNING, rtwdev->flags);
 
+	/* mac80211 re-adds every vif on restart without removing it first, so
+	 * no deferred beacon update may stay armed across a stop. The list is
+	 * walked under the mutex; a work that already runs sees RUNNING
+	 * cleared and is flushed by the restart before the vif is re-added.
+	 */
+	rtw89_for_each_rtwvif(rtwdev, rtwvif)
+		cancel_delayed_work(&rtwvif->update_beacon_work);
+
 	mutex_unlock(&rtwdev->mutex);
 
 	cancel_work_sync(&rtwdev->c2h_work);
-	cancel_work_sync(&btc->eapol_notify_work);
-	cancel_work_sync(&btc->arp_notify_work);
-	cancel_work_sync(&btc->dhcp_notify_work);
-	cancel_work_sync(&btc->icmp_notify_work);
+	cancel_delayed_work_sync(&btc->spec_pkt_notify_work);
+	btc->spec_pkt_pending = 0;
 	cancel_delayed_work_sync(&rtwdev->txq_reinvoke_work);
 	cancel_delayed_work_sync(&rtwdev->track_work);
 	cancel_delayed_work_sync(&rtwdev->coex_act1_work);
@@ -2440,11 +2787,153 @@ void rtw89_core_stop(struct rtw89_dev *rtwdev)
 	rtw89_hci_flush_queues(rtwdev, BIT(rtwdev->hw->queues) - 1, true);
 	rtw89_mac_flush_txq(rtwdev, BIT(rtwdev->hw->queues) - 1, true);
 	rtw89_hci_stop(rtwdev);
+
+	/* after the last H2C of the stop sequence. The work cannot be synced
+	 * under the mutex; if it already waits for it, it sees RUNNING cleared
+	 * and drops the queue.
+	 */
+	cancel_delayed_work(&rtwdev->fw.h2c_txq.work);
+	rtw89_core_h2c_txq_purge(rtwdev);
+
 	rtw89_hci_deinit(rtwdev);
 	rtw89_mac_pwr_off(rtwdev);
 	rtw89_hci_reset(rtwdev);
 }
 
+static int rtw89_shadow_index(struct rtw89_dev *rtwdev, u32 addr)
+{
+	const struct rtw89_chip_info *chip = rtwdev->chip;
+	const struct rtw89_reg_range *range;
+	u32 base = 0;
+	u8 i;
+
+	for (i = 0; i < chip->shadow_range_num; i++) {
+		range = &chip->shadow_ranges[i];
+		if (addr >= range->start && addr < range->end)
+			return base + ((addr - range->start) >> 2);
+		base += (range->end - range->start) >> 2;
+	}
+
+	return -1;
+}
+
+void rtw89_shadow_store(struct rtw89_dev *rtwdev, u32 addr, u32 data)
+{
+	struct rtw89_shadow_regs *shadow = &rtwdev->shadow;
+	int idx = rtw89_shadow_index(rtwdev, addr);
+
+	if (idx < 0)
+		return;
+
+	shadow->vals[idx] = data;
+	set_bit(idx, shadow->valid);
+}
+EXPORT_SYMBOL(rtw89_shadow_store);
+
+void rtw89_shadow_drop(struct rtw89_dev *rtwdev, u32 addr)
+{
+	int idx = rtw89_shadow_index(rtwdev, addr & ~0x3);
+
+	if (idx >= 0)
+		clear_bit(idx, rtwdev->shadow.valid);
+}
+EXPORT_SYMBOL(rtw89_shadow_drop);
+
+static u32 __rtw89_shadow_load(struct rtw89_dev *rtwdev, u32 addr)
+{
+	struct rtw89_shadow_regs *shadow = &rtwdev->shadow;
+	int idx = rtw89_shadow_index(rtwdev, addr);
+	u32 val, hw;
+
+	if (idx < 0)
+		return rtw89_read32(rtwdev, addr);
+
+	if (!test_bit(idx, shadow->valid)) {
+		shadow->miss++;
+		val = rtw89_read32(rtwdev, addr);
+		shadow->vals[idx] = val;
+		set_bit(idx, shadow->valid);
+		return val;
+	}
+
+	shadow->hit++;
+	val = shadow->vals[idx];
+	if (!shadow->verify)
+		return val;
+
+	hw = rtw89_read32(rtwdev, addr);
+	if (hw != val) {
+		shadow->mismatch++;
+		dev_warn_ratelimited(rtwdev->dev,
+				     "shadow reg 0x%x: cached 0x%08x, hw 0x%08x\n",
+				     addr, val, hw);
+		shadow->vals[idx] = hw;
+	}
+
+	return hw;
+}
+
+u32 rtw89_shadow_load(struct rtw89_dev *rtwdev, u32 addr)
+{
+	bool tagged = rtw89_mmio_prof_tag(rtwdev, _RET_IP_);
+	u32 val;
+
+	val = __rtw89_shadow_load(rtwdev, addr);
+	rtw89_mmio_prof_untag(rtwdev, tagged);
+
+	return val;
+}
+EXPORT_SYMBOL(rtw89_shadow_load);
+
+/* register contents are lost on power cycles */
+void rtw89_shadow_reset(struct rtw89_dev *rtwdev)
+{
+	struct rtw89_shadow_regs *shadow = &rtwdev->shadow;
+
+	if (shadow->valid)
+		bitmap_zero(shadow->valid, shadow->n_regs);
+}
+
+static int rtw89_shadow_init(struct rtw89_dev *rtwdev)
+{
+	const struct rtw89_chip_info *chip = rtwdev->chip;
+	struct rtw89_shadow_regs *shadow = &rtwdev->shadow;
+	u32 n_regs = 0;
+	u8 i;
+
+	for (i = 0; i < chip->shadow_range_num; i++)
+		n_regs += (chip->shadow_ranges[i].end -
+			   chip->shadow_ranges[i].start) >> 2;
+	if (!n_regs)
+		return 0;
+
+	shadow->vals = kvcalloc(n_regs, sizeof(*shadow->vals), GFP_KERNEL);
+	shadow->valid = bitmap_zalloc(n_regs, GFP_KERNEL);
+	if (!shadow->vals || !shadow->valid) {
+		kvfree(shadow->vals);
+		bitmap_free(shadow->valid);
+		shadow->vals = NULL;
+		shadow->valid = NULL;
+		return -ENOMEM;
+	}
+
+	shadow->n_regs = n_regs;
+	shadow->enable = rtw89_shadow_regs_en;
+
+	return 0;
+}
+
+static void rtw89_shadow_deinit(struct rtw89_dev *rtwdev)
+{
+	struct rtw89_shadow_regs *shadow = &rtwdev->shadow;
+
+	shadow->enable = false;
+	kvfree(shadow->vals);
+	bitmap_free(shadow->valid);
+	shadow->vals = NULL;
+	shadow->valid = NULL;
+}
+
 int rtw89_core_init(struct rtw89_dev *rtwdev)
 {
 	struct rtw89_btc *btc = &rtwdev->btc;
@@ -2469,20 +2958,53 @@ int rtw89_core_init(struct rtw89_dev *rtwdev)
 
 	INIT_WORK(&rtwdev->c2h_work, rtw89_fw_c2h_work);
 	skb_queue_head_init(&rtwdev->c2h_queue);
+	rtw89_fw_h2c_ack_init(rtwdev);
+	rtw89_fw_reg_mbox_init(rtwdev);
+	spin_lock_init(&rtwdev->fw.log_relay.lock);
+	spin_lock_init(&rtwdev->fw.h2c_txq.lock);
+	__skb_queue_head_init(&rtwdev->fw.h2c_txq.queue);
+	INIT_DELAYED_WORK(&rtwdev->fw.h2c_txq.work, rtw89_core_h2c_txq_work);
 	rtw89_core_ppdu_sts_init(rtwdev);
-	rtw89_traffic_stats_init(rtwdev, &rtwdev->stats);
+	ret = rtw89_tx_ll_stats_init(rtwdev);
+	if (ret)
+		return ret;
 
+	ret = rtw89_traffic_stats_init(rtwdev, &rtwdev->stats);
+	if (ret) {
+		rtw89_tx_ll_stats_deinit(rtwdev);
+		return ret;
+	}
+
+	ret = rtw89_fw_h2c_arena_init(rtwdev);
+	if (ret) {
+		rtw89_traffic_stats_deinit(rtwdev, &rtwdev->stats);
+		rtw89_tx_ll_stats_deinit(rtwdev);
+		return ret;
+	}
+
+	ret = rtw89_shadow_init(rtwdev);
+	if (ret) {
+		rtw89_fw_h2c_arena_deinit(rtwdev);
+		rtw89_traffic_stats_deinit(rtwdev, &rtwdev->stats);
+		rtw89_tx_ll_stats_deinit(rtwdev);
+		return ret;
+	}
+
+	rtw89_mmio_prof_init(rtwdev);
 	rtwdev->ps_mode = rtw89_update_ps_mode(rtwdev);
 	rtwdev->hal.rx_fltr = DEFAULT_AX_RX_FLTR;
 
-	INIT_WORK(&btc->eapol_notify_work, rtw89_btc_ntfy_eapol_packet_work);
-	INIT_WORK(&btc->arp_notify_work, rtw89_btc_ntfy_arp_packet_work);
-	INIT_WORK(&btc->dhcp_notify_work, rtw89_btc_ntfy_dhcp_packet_work);
-	INIT_WORK(&btc->icmp_notify_work, rtw89_btc_ntfy_icmp_packet_work);
+	INIT_DELAYED_WORK(&btc->spec_pkt_notify_work,
+			  rtw89_btc_ntfy_specific_packet_work);
 
 	ret = rtw89_load_firmware(rtwdev);
 	if (ret) {
 		rtw89_warn(rtwdev, "no firmware loaded\n");
+		rtw89_mmio_prof_deinit(rtwdev);
+		rtw89_shadow_deinit(rtwdev);
+		rtw89_fw_h2c_arena_deinit(rtwdev);
+		rtw89_traffic_stats_deinit(rtwdev, &rtwdev->stats);
+		rtw89_tx_ll_stats_deinit(rtwdev);
 		return ret;
 	}
 	rtw89_ser_init(rtwdev);
@@ -2496,13 +3018,119 @@ void rtw89_core_deinit(struct rtw89_dev *rtwdev)
 	rtw89_ser_deinit(rtwdev);
 	rtw89_unload_firmware(rtwdev);
 	rtw89_fw_free_all_early_h2c(rtwdev);
+	rtw89_phy_tables_free(rtwdev);
 
+	cancel_delayed_work_sync(&rtwdev->fw.h2c_txq.work);
+	rtw89_core_h2c_txq_purge(rtwdev);
 	destroy_workqueue(rtwdev->txq_wq);
+	rtw89_mmio_prof_deinit(rtwdev);
+	rtw89_shadow_deinit(rtwdev);
+	rtw89_fw_h2c_arena_deinit(rtwdev);
+	rtw89_traffic_stats_deinit(rtwdev, &rtwdev->stats);
+	rtw89_tx_ll_stats_deinit(rtwdev);
 	mutex_destroy(&rtwdev->rf_mutex);
 	mutex_destroy(&rtwdev->mutex);
 }
 EXPORT_SYMBOL(rtw89_core_deinit);
 
+static void rtw89_reg_batch_issue(struct rtw89_dev *rtwdev,
+				  struct rtw89_reg_batch *batch)
+{
+	u32 val;
+	u8 i;
+
+	for (i = 0; i < batch->n; i++) {
+		val = batch->ent[i].data;
+		if (batch->ent[i].mask != MASKDWORD)
+			val |= rtw89_read32_rmw(rtwdev, batch->ent[i].addr) &
+			       ~batch->ent[i].mask;
+		rtw89_write32(rtwdev, batch->ent[i].addr, val);
+	}
+
+	if (batch->n) {
+		batch->last_addr = batch->ent[batch->n - 1].addr;
+		batch->pending = true;
+	}
+	batch->n = 0;
+}
+
+static void rtw89_reg_batch_add(struct rtw89_dev *rtwdev,
+				struct rtw89_reg_batch *batch,
+				u32 addr, u32 mask, u32 data)
+{
+	u8 n = batch->n;
+
+	WARN(addr & 0x3, "should be 4-byte aligned, addr = 0x%08x\n", addr);
+
+	/* a field written twice may be a strobe, keep both writes then */
+	if (n && batch->ent[n - 1].addr == addr &&
+	    !(batch->ent[n - 1].mask & mask)) {
+		batch->ent[n - 1].data &= ~mask;
+		batch->ent[n - 1].data |= data;
+		batch->ent[n - 1].mask |= mask;
+		return;
+	}
+
+	if (n == RTW89_REG_BATCH_NUM) {
+		rtw89_reg_batch_issue(rtwdev, batch);
+		n = 0;
+	}
+
+	batch->ent[n].addr = addr;
+	batch->ent[n].mask = mask;
+	batch->ent[n].data = data;
+	batch->n = n + 1;
+}
+
+void rtw89_reg_batch_write32_mask(struct rtw89_dev *rtwdev,
+				  struct rtw89_reg_batch *batch,
+				  u32 addr, u32 mask, u32 data)
+{
+	bool tagged = rtw89_mmio_prof_tag(rtwdev, _RET_IP_);
+
+	rtw89_reg_batch_add(rtwdev, batch, addr, mask,
+			    (data << __ffs(mask)) & mask);
+	rtw89_mmio_prof_untag(rtwdev, tagged);
+}
+
+void rtw89_reg_batch_write32_set(struct rtw89_dev *rtwdev,
+				 struct rtw89_reg_batch *batch,
+				 u32 addr, u32 bits)
+{
+	bool tagged = rtw89_mmio_prof_tag(rtwdev, _RET_IP_);
+
+	rtw89_reg_batch_add(rtwdev, batch, addr, bits, bits);
+	rtw89_mmio_prof_untag(rtwdev, tagged);
+}
+
+void rtw89_reg_batch_write32_clr(struct rtw89_dev *rtwdev,
+				 struct rtw89_reg_batch *batch,
+				 u32 addr, u32 bits)
+{
+	bool tagged = rtw89_mmio_prof_tag(rtwdev, _RET_IP_);
+
+	rtw89_reg_batch_add(rtwdev, batch, addr, bits, 0);
+	rtw89_mmio_prof_untag(rtwdev, tagged);
+}
+
+/* Issue what is left and read back once, so that all writes have reached
+ * the chip before the caller waits or touches registers another way.
+ */
+void rtw89_reg_batch_flush(struct rtw89_dev *rtwdev,
+			   struct rtw89_reg_batch *batch)
+{
+	bool tagged = rtw89_mmio_prof_tag(rtwdev, _RET_IP_);
+
+	rtw89_reg_batch_issue(rtwdev, batch);
+
+	if (batch->pending) {
+		rtw89_read32(rtwdev, batch->last_addr);
+		batch->pending = false;
+	}
+
+	rtw89_mmio_prof_untag(rtwdev, tagged);
+}
+
 static void rtw89_read_chip_ver(struct rtw89_dev *rtwdev)
 {
 	u8 cv;
@@ -2585,6 +3213,8 @@ int rtw89_chip_info_setup(struct rtw89_dev *rtwdev)
 	if (ret)
 		return ret;
 
+	rtw89_phy_tables_setup(rtwdev);
+
 	return 0;
 }
 EXPORT_SYMBOL(rtw89_chip_info_setup);
@@ -2683,6 +3313,7 @@ EXPORT_SYMBOL(rtw89_core_register);
 
 void rtw89_core_unregister(struct rtw89_dev *rtwdev)
 {
+	rtw89_debugfs_deinit(rtwdev);
 	rtw89_core_unregister_hw(rtwdev);
 }
 EXPORT_SYMBOL(rtw89_core_unregister);
@@ -9,10 +9,15 @@
 #include <linux/bitfield.h>
 #include <linux/firmware.h>
 #include <linux/iopoll.h>
+#include <linux/percpu.h>
+#include <linux/u64_stats_sync.h>
+#include <linux/wait.h>
 #include <linux/workqueue.h>
 #include <net/mac80211.h>
 #include <linux/version.h>
 
+#include "reg.h"
+
 struct rtw89_dev;
 
 extern const struct ieee80211_ops rtw89_ops;
@@ -30,6 +35,7 @@ extern const struct rtw89_chip_info rtw8852a_chip_info;
 #define INV_RF_DATA 0xffffffff
 
 #define RTW89_TRACK_WORK_PERIOD	round_jiffies_relative(HZ * 2)
+#define RTW89_H2C_TXQ_RETRY_PERIOD msecs_to_jiffies(2)
 #define CFO_TRACK_MAX_USER 64
 #define MAX_RSSI 110
 #define RSSI_FACTOR 1
@@ -459,6 +465,36 @@ struct rtw89_txpwr_limit_ru {
 	s8 ru106[RTW89_RU_SEC_NUM];
 };
 
+/* TX power limits, [bw][ntx][rs][bf][regd][ch] or [ru][ntx][regd][ch], with
+ * every distinct channel row stored once in a pool; see table_pack.py
+ */
+struct rtw89_txpwr_lmt_dict {
+	/* pool row of each [..][regd] */
+	const u8 *rows;
+	const s8 *pool;
+	u8 ch_num;
+};
+
+#define RTW89_TXPWR_LMT_CACHE_NUM 16
+
+/* Final limit and RU limit pages of one channel, for each TX count */
+struct rtw89_txpwr_lmt_rec {
+	bool valid;
+	u8 band;
+	u8 ch;
+	u8 bw;
+	struct rtw89_txpwr_limit lmt[RTW89_NTX_NUM];
+	struct rtw89_txpwr_limit_ru lmt_ru[RTW89_NTX_NUM];
+};
+
+/* valid for the current regulatory and SAR state only */
+struct rtw89_txpwr_lmt_cache {
+	struct rtw89_txpwr_lmt_rec recs[RTW89_TXPWR_LMT_CACHE_NUM];
+	u8 next;
+	u32 hit;
+	u32 miss;
+};
+
 struct rtw89_rate_desc {
 	enum rtw89_nss nss;
 	enum rtw89_rate_section rs;
@@ -867,7 +903,45 @@ enum rtw89_tfc_lv {
 #define RTW89_TP_SHIFT 18 /* bytes/2s --> Mbps */
 DECLARE_EWMA(tp, 10, 2);
 
+#if LINUX_VERSION_CODE < KERNEL_VERSION(5, 5, 0)
+typedef struct {
+	u64 v;
+} u64_stats_t;
+
+static inline u64 u64_stats_read(const u64_stats_t *p)
+{
+	return p->v;
+}
+
+static inline void u64_stats_add(u64_stats_t *p, unsigned long val)
+{
+	p->v += val;
+}
+
+static inline void u64_stats_inc(u64_stats_t *p)
+{
+	p->v++;
+}
+#endif
+
+/* hot counters updated per packet from both TX and RX (NAPI) paths */
+struct rtw89_traffic_stats_pcpu {
+	u64_stats_t tx_unicast;
+	u64_stats_t rx_unicast;
+	u64_stats_t tx_cnt;
+	u64_stats_t rx_cnt;
+	struct u64_stats_sync syncp;
+};
+
 struct rtw89_traffic_stats {
+	struct rtw89_traffic_stats_pcpu __percpu *pcpu;
+
+	/* running totals of pcpu counters at the last fold */
+	u64 tx_unicast_folded;
+	u64 rx_unicast_folded;
+	u64 tx_cnt_folded;
+	u64 rx_cnt_folded;
+
 	/* units in bytes */
 	u64 tx_unicast;
 	u64 rx_unicast;
@@ -1728,10 +1802,10 @@ struct rtw89_btc {
 	struct rtw89_btc_btf_fwinfo fwinfo;
 	struct rtw89_btc_dbg dbg;
 
-	struct work_struct eapol_notify_work;
-	struct work_struct arp_notify_work;
-	struct work_struct dhcp_notify_work;
-	struct work_struct icmp_notify_work;
+	/* special packets seen on TX, coalesced into one notification */
+	struct delayed_work spec_pkt_notify_work;
+	unsigned long spec_pkt_pending;
+	unsigned long spec_pkt_last;
 
 	u32 bt_req_len;
 
@@ -1930,6 +2004,17 @@ struct rtw89_phy_rate_pattern {
 	bool enable;
 };
 
+#define RTW89_BCN_UPD_HDR_LEN 12
+
+/* last beacon template sent to firmware */
+struct rtw89_bcn_cache {
+	struct sk_buff *skb;
+	u8 hdr[RTW89_BCN_UPD_HDR_LEN] __aligned(4);
+	unsigned long last_upd;
+	u32 upd_cnt;
+	u32 skip_cnt;
+};
+
 struct rtw89_vif {
 	struct list_head list;
 	struct rtw89_dev *rtwdev;
@@ -1954,7 +2039,8 @@ struct rtw89_vif {
 	bool wowlan_magic;
 	bool is_hesta;
 	bool last_a_ctrl;
-	struct work_struct update_beacon_work;
+	struct delayed_work update_beacon_work;
+	struct rtw89_bcn_cache bcn_cache;
 	struct rtw89_addr_cam_entry addr_cam;
 	struct rtw89_bssid_cam_entry bssid_cam;
 	struct ieee80211_tx_queue_params tx_params[IEEE80211_NUM_ACS];
@@ -1998,6 +2084,8 @@ struct rtw89_hci_info {
 	enum rtw89_hci_type type;
 	u32 rpwm_addr;
 	u32 cpwm_addr;
+	/* register window of an HCI mapping registers in memory space */
+	void __iomem *mmio;
 };
 
 struct rtw89_chip_ops {
@@ -2008,6 +2096,10 @@ struct rtw89_chip_ops {
 		       u32 addr, u32 mask);
 	bool (*write_rf)(struct rtw89_dev *rtwdev, enum rtw89_rf_path rf_path,
 			 u32 addr, u32 mask, u32 data);
+	/* write_rf without the settling delay, the caller paces the writes */
+	bool (*write_rf_nodelay)(struct rtw89_dev *rtwdev,
+				 enum rtw89_rf_path rf_path,
+				 u32 addr, u32 mask, u32 data);
 	void (*set_channel)(struct rtw89_dev *rtwdev,
 			    struct rtw89_channel_params *param);
 	void (*set_channel_help)(struct rtw89_dev *rtwdev, bool enter,
@@ -2188,10 +2280,80 @@ struct rtw89_reg5_def {
 	u32 data;
 };
 
+/* byte stream made by table_pack.py, see rtw89_phy_table_next() */
+struct rtw89_phy_packed_table {
+	const u8 *data;
+	u32 len;
+	/* condition entries, referred to by index from the stream */
+	const struct rtw89_reg2_def *conds;
+	u8 n_conds;
+	u32 n_regs;
+	u8 stride;
+};
+
 struct rtw89_phy_table {
 	const struct rtw89_reg2_def *regs;
 	u32 n_regs;
 	enum rtw89_rf_path rf_path;
+	/* used instead of regs when set */
+	const struct rtw89_phy_packed_table *packed;
+};
+
+/* phy table with conditions resolved for this board, see
+ * rtw89_phy_tables_setup()
+ */
+struct rtw89_phy_flat_table {
+	struct rtw89_reg2_def *regs;
+	u32 n_regs;
+	u32 n_src;
+	/* redundant writes removed, saved on every replay */
+	u32 n_dropped;
+	/* cost of one conditional walk, saved on every replay */
+	u32 walk_us;
+	u32 replay_cnt;
+	/* last replay: wall time, and its split into CPU and sleep */
+	u32 replay_us;
+	u32 cpu_us;
+	u32 sleep_us;
+};
+
+struct rtw89_phy_flat_tables {
+	struct rtw89_phy_flat_table bb;
+	struct rtw89_phy_flat_table rf[RF_PATH_MAX];
+	struct rtw89_phy_flat_table nctl;
+	/* replay state */
+	u64 sleep_ns;
+	u64 rf_write_ns;
+};
+
+enum rtw89_tbl_blob_id {
+	RTW89_TBL_BB,
+	RTW89_TBL_NCTL,
+	RTW89_TBL_RF_A,
+	RTW89_TBL_RF_B,
+	RTW89_TBL_RF_C,
+	RTW89_TBL_RF_D,
+	RTW89_TBL_LMT_2G,
+	RTW89_TBL_LMT_5G,
+	RTW89_TBL_LMT_RU_2G,
+	RTW89_TBL_LMT_RU_5G,
+
+	RTW89_TBL_NUM,
+	RTW89_TBL_PHY_NUM = RTW89_TBL_LMT_2G,
+	RTW89_TBL_LMT_NUM = RTW89_TBL_NUM - RTW89_TBL_LMT_2G,
+};
+
+/* tables loaded from chip->table_name; the stream, rows and pool point into
+ * the firmware buffer, which is kept until the device goes away
+ */
+struct rtw89_phy_tbl_blob {
+	const struct firmware *firmware;
+	u32 version;
+	u32 load_us;
+	struct rtw89_reg2_def *conds;
+	struct rtw89_phy_packed_table packed[RTW89_TBL_PHY_NUM];
+	struct rtw89_phy_table phy[RTW89_TBL_PHY_NUM];
+	struct rtw89_txpwr_lmt_dict lmt[RTW89_TBL_LMT_NUM];
 };
 
 struct rtw89_txpwr_table {
@@ -2201,16 +2363,27 @@ struct rtw89_txpwr_table {
 		     const struct rtw89_txpwr_table *tbl);
 };
 
+/* [start, end) MMIO range */
+struct rtw89_reg_range {
+	u32 start;
+	u32 end;
+};
+
 struct rtw89_chip_info {
 	enum rtw89_core_chip_id chip_id;
 	const struct rtw89_chip_ops *ops;
 	const char *fw_name;
+	/* optional, overrides the compiled-in PHY tables */
+	const char *table_name;
 	u32 fifo_size;
 	u16 max_amsdu_limit;
 	bool dis_2g_40m_ul_ofdma;
 	const struct rtw89_hfc_param_ini *hfc_param_ini;
 	const struct rtw89_dle_mem *dle_mem;
 	u32 rf_base_addr[2];
+	/* registers only the driver writes, which may be shadowed */
+	const struct rtw89_reg_range *shadow_ranges;
+	u8 shadow_range_num;
 	u8 rf_path_num;
 	u8 tx_nss;
 	u8 rx_nss;
@@ -2232,16 +2405,10 @@ struct rtw89_chip_info {
 	const struct rtw89_phy_table *nctl_table;
 	const struct rtw89_txpwr_table *byr_table;
 	const struct rtw89_phy_dig_gain_table *dig_table;
-	const s8 (*txpwr_lmt_2g)[RTW89_2G_BW_NUM][RTW89_NTX_NUM]
-				[RTW89_RS_LMT_NUM][RTW89_BF_NUM]
-				[RTW89_REGD_NUM][RTW89_2G_CH_NUM];
-	const s8 (*txpwr_lmt_5g)[RTW89_5G_BW_NUM][RTW89_NTX_NUM]
-				[RTW89_RS_LMT_NUM][RTW89_BF_NUM]
-				[RTW89_REGD_NUM][RTW89_5G_CH_NUM];
-	const s8 (*txpwr_lmt_ru_2g)[RTW89_RU_NUM][RTW89_NTX_NUM]
-				   [RTW89_REGD_NUM][RTW89_2G_CH_NUM];
-	const s8 (*txpwr_lmt_ru_5g)[RTW89_RU_NUM][RTW89_NTX_NUM]
-				   [RTW89_REGD_NUM][RTW89_5G_CH_NUM];
+	const struct rtw89_txpwr_lmt_dict *txpwr_lmt_2g;
+	const struct rtw89_txpwr_lmt_dict *txpwr_lmt_5g;
+	const struct rtw89_txpwr_lmt_dict *txpwr_lmt_ru_2g;
+	const struct rtw89_txpwr_lmt_dict *txpwr_lmt_ru_5g;
 
 	u8 txpwr_factor_rf;
 	u8 txpwr_factor_mac;
@@ -2314,6 +2481,8 @@ struct rtw89_fw_suit {
 	u16 build_hour;
 	u16 build_min;
 	u8 cmd_ver;
+	/* parsed sections and chunk copies, built on first download */
+	struct rtw89_fw_dl_cache *dl_cache;
 };
 
 #define RTW89_FW_VER_CODE(major, minor, sub, idx)	\
@@ -2321,12 +2490,152 @@ struct rtw89_fw_suit {
 #define RTW89_FW_SUIT_VER_CODE(s)	\
 	RTW89_FW_VER_CODE((s)->major_ver, (s)->minor_ver, (s)->sub_ver, (s)->sub_idex)
 
+struct rtw89_h2c_batch {
+	/* nesting level of rtw89_fw_h2c_batch_begin() */
+	u8 depth;
+	/* H2Cs written to CH12 but not kicked yet */
+	u8 pending;
+};
+
+enum rtw89_h2c_ack_type {
+	RTW89_H2C_ACK_REC,
+	RTW89_H2C_ACK_DONE,
+
+	RTW89_H2C_ACK_NUM,
+};
+
+enum rtw89_h2c_ack_lat {
+	RTW89_H2C_ACK_LAT_100US,
+	RTW89_H2C_ACK_LAT_500US,
+	RTW89_H2C_ACK_LAT_1MS,
+	RTW89_H2C_ACK_LAT_5MS,
+	RTW89_H2C_ACK_LAT_20MS,
+	RTW89_H2C_ACK_LAT_SLOW,
+
+	RTW89_H2C_ACK_LAT_NUM,
+};
+
+struct rtw89_h2c_ack_ent {
+	ktime_t submit;
+	/* BIT(enum rtw89_h2c_ack_type) of acks still expected */
+	u8 wait;
+	/* return code carried by the done ack */
+	u8 ret;
+};
+
+struct rtw89_h2c_ack_info {
+	/* protects ent[] and counters, taken from NAPI context */
+	spinlock_t lock;
+	wait_queue_head_t wq;
+	struct rtw89_h2c_ack_ent ent[U8_MAX + 1];
+	u32 outstanding;
+	u32 lost;
+	u32 timeout;
+	u32 hist[RTW89_H2C_ACK_NUM][RTW89_H2C_ACK_LAT_NUM];
+	u32 lat_max_us[RTW89_H2C_ACK_NUM];
+};
+
+#define FWDL_SECTION_MAX_NUM 10
+
+struct rtw89_fw_dl_section_stats {
+	u32 len;
+	u32 pkt_cnt;
+	u32 kick_cnt;
+	u32 time_us;
+};
+
+/* timing of the last firmware download */
+struct rtw89_fw_dl_stats {
+	u32 dl_cnt;
+	u32 hdr_us;
+	u32 rdy_us;
+	u32 total_us;
+	u32 credit_wait_cnt;
+	u32 chunk_reused;
+	u32 chunk_copied;
+	u8 section_num;
+	struct rtw89_fw_dl_section_stats section[FWDL_SECTION_MAX_NUM];
+};
+
+/* H2Cs waiting for CH12 credit, i.e. free FWCMD BDs */
+struct rtw89_h2c_txq {
+	spinlock_t lock;
+	struct sk_buff_head queue;
+	struct delayed_work work;
+	u32 queued;
+	u32 stalls;
+	u32 dropped;
+	u32 max_depth;
+};
+
+#define RTW89_C2H_STATS_CAT_NUM 4
+#define RTW89_C2H_STATS_CLASS_NUM 64
+
+struct rtw89_c2h_class_stats {
+	u32 cnt;
+	u32 max_us;
+	u64 total_us;
+};
+
+struct rtw89_c2h_stats {
+	u32 batch_cnt;
+	u32 max_batch;
+	u32 atomic_cnt;
+	u32 locked_cnt;
+	struct rtw89_c2h_class_stats cls[RTW89_C2H_STATS_CAT_NUM][RTW89_C2H_STATS_CLASS_NUM];
+};
+
+struct rchan;
+
+/* binary firmware log stream exported through relayfs */
+struct rtw89_fw_log_relay {
+	spinlock_t lock;
+	struct rchan *rchan;
+	u32 seq;
+	u32 rec_cnt;
+	u32 drop_cnt;
+	u64 bytes;
+};
+
+#define RTW89_H2C_ARENA_NUM 16
+
+/* reusable, pre-sized buffers for periodic H2C commands */
+struct rtw89_h2c_arena {
+	spinlock_t lock;
+	struct sk_buff *bufs[RTW89_H2C_ARENA_NUM];
+	int headroom;
+	u8 next;
+	u32 hit;
+	u32 miss;
+};
+
+/* register based H2C/C2H mailbox */
+struct rtw89_fw_reg_mbox {
+	struct completion c2h_done;
+	/* HCI interrupts are up and report C2H register events */
+	bool irq_ready;
+	u32 irq_cnt;
+	u32 poll_cnt;
+	u32 fail_cnt;
+	u32 rtt_cnt;
+	u32 rtt_max_us;
+	u64 rtt_sum_us;
+};
+
 struct rtw89_fw_info {
 	const struct firmware *firmware;
 	struct rtw89_dev *rtwdev;
 	struct completion completion;
 	u8 h2c_seq;
 	u8 rec_seq;
+	struct rtw89_h2c_batch h2c_batch;
+	struct rtw89_h2c_ack_info h2c_ack;
+	struct rtw89_h2c_txq h2c_txq;
+	struct rtw89_fw_dl_stats dl_stats;
+	struct rtw89_c2h_stats c2h_stats;
+	struct rtw89_fw_reg_mbox reg_mbox;
+	struct rtw89_h2c_arena h2c_arena;
+	struct rtw89_fw_log_relay log_relay;
 	struct rtw89_fw_suit normal;
 	struct rtw89_fw_suit wowlan;
 	bool fw_log_enable;
@@ -2789,6 +3098,59 @@ struct rtw89_early_h2c {
 	u16 h2c_len;
 };
 
+struct rtw89_tx_flow {
+	/* mac80211 queues stopped due to lack of HCI resource */
+	unsigned long stopped;
+	u32 stop_cnt[IEEE80211_NUM_ACS];
+	u32 wake_cnt[IEEE80211_NUM_ACS];
+	u32 drop_cnt[IEEE80211_NUM_ACS];
+};
+
+/* frames on the low-latency channel, mgmt and port control (EAPOL); counted
+ * per CPU from the TX path and from NAPI
+ */
+struct rtw89_tx_ll_stats {
+	u64_stats_t mgmt_cnt;
+	u64_stats_t eapol_cnt;
+	u64_stats_t acked;
+	u64_stats_t failed;
+	u64_stats_t lat_sum_us;
+	u32 lat_max_us;
+	struct u64_stats_sync syncp;
+};
+
+/* Last written value of each register in chip->shadow_ranges, so that
+ * read-modify-write helpers can skip the MMIO read.
+ */
+struct rtw89_shadow_regs {
+	bool enable;
+	/* read hardware on every hit too, and compare */
+	bool verify;
+	u32 *vals;
+	unsigned long *valid;
+	u32 n_regs;
+	u32 hit;
+	u32 miss;
+	u32 mismatch;
+};
+
+#define RTW89_REG_BATCH_NUM 16
+
+/* Masked 32-bit writes collected on the stack and issued back to back.
+ * Consecutive writes to disjoint fields of a word are merged into one access.
+ */
+struct rtw89_reg_batch {
+	u8 n;
+	bool pending;
+	u32 last_addr;
+	struct {
+		u32 addr;
+		u32 mask;
+		/* already shifted into mask */
+		u32 data;
+	} ent[RTW89_REG_BATCH_NUM];
+};
+
 struct rtw89_dev {
 	struct ieee80211_hw *hw;
 	struct device *dev;
@@ -2799,6 +3161,10 @@ struct rtw89_dev {
 	struct rtw89_mac_info mac;
 	struct rtw89_fw_info fw;
 	struct rtw89_hci_info hci;
+	struct rtw89_shadow_regs shadow;
+#ifdef CONFIG_RTW89_MMIO_PROF
+	struct rtw89_mmio_prof *mmio_prof;
+#endif
 	struct rtw89_efuse efuse;
 	struct rtw89_traffic_stats stats;
 
@@ -2810,6 +3176,8 @@ struct rtw89_dev {
 	struct workqueue_struct *txq_wq;
 	struct work_struct txq_work;
 	struct delayed_work txq_reinvoke_work;
+	struct rtw89_tx_flow tx_flow;
+	struct rtw89_tx_ll_stats __percpu *tx_ll_stats;
 	/* used to protect ba_list */
 	spinlock_t ba_lock;
 	/* txqs to setup ba session */
@@ -2830,6 +3198,8 @@ struct rtw89_dev {
 	DECLARE_BITMAP(flags, NUM_OF_RTW89_FLAGS);
 
 	struct rtw89_phy_stat phystat;
+	struct rtw89_phy_flat_tables phy_flat;
+	struct rtw89_phy_tbl_blob tbl_blob;
 	struct rtw89_dack_info dack;
 	struct rtw89_iqk_info iqk;
 	struct rtw89_dpk_info dpk;
@@ -2856,6 +3226,7 @@ struct rtw89_dev {
 
 	const struct rtw89_regulatory *regd;
 	struct rtw89_sar_info sar;
+	struct rtw89_txpwr_lmt_cache txpwr_lmt_cache;
 
 	struct rtw89_btc btc;
 	enum rtw89_ps_mode ps_mode;
@@ -2918,37 +3289,173 @@ static inline void rtw89_hci_flush_queues(struct rtw89_dev *rtwdev, u32 queues,
 		return rtwdev->hci.ops->flush_queues(rtwdev, queues, drop);
 }
 
-static inline u8 rtw89_read8(struct rtw89_dev *rtwdev, u32 addr)
+void rtw89_shadow_store(struct rtw89_dev *rtwdev, u32 addr, u32 data);
+void rtw89_shadow_drop(struct rtw89_dev *rtwdev, u32 addr);
+u32 rtw89_shadow_load(struct rtw89_dev *rtwdev, u32 addr);
+
+#define ACCESS_CMAC(_addr) \
+	({typeof(_addr) __addr = (_addr); \
+	  __addr >= R_AX_CMAC_REG_START && __addr <= R_AX_CMAC_REG_END; })
+
+#ifdef CONFIG_RTW89_HCI_PCI_ONLY
+/* Only the PCIe HCI is built, so registers are accessed through its memory
+ * window directly instead of an indirect call per access. CMAC reads still
+ * go to the HCI, which retries them while the CMAC clock is gated.
+ */
+#define RTW89_HCI_DIRECT_IO 1
+
+static inline bool rtw89_hci_direct_read(u32 addr)
+{
+	return !ACCESS_CMAC(addr);
+}
+#else
+#define RTW89_HCI_DIRECT_IO 0
+
+static inline bool rtw89_hci_direct_read(u32 addr)
+{
+	return false;
+}
+#endif
+
+#ifdef CONFIG_RTW89_MMIO_PROF
+struct rtw89_mmio_prof;
+void rtw89_mmio_prof_record(struct rtw89_dev *rtwdev, unsigned long ip,
+			    u32 addr, bool write, u64 start_ns);
+bool rtw89_mmio_prof_tag(struct rtw89_dev *rtwdev, unsigned long ip);
+void rtw89_mmio_prof_untag(struct rtw89_dev *rtwdev, bool tagged);
+
+/* The accessors are always inlined, so _THIS_IP_ lands in their caller.
+ * Shared helpers tag the accesses they make with their own caller instead.
+ */
+#define rtw89_mmio_prof_read(rtwdev, addr, access)			\
+	({								\
+		u64 __start = ktime_get_ns();				\
+		typeof(access) __val = (access);			\
+									\
+		rtw89_mmio_prof_record(rtwdev, _THIS_IP_, addr, false,	\
+				       __start);			\
+		__val;							\
+	})
+#define rtw89_mmio_prof_write(rtwdev, addr, access)			\
+	do {								\
+		u64 __start = ktime_get_ns();				\
+									\
+		access;							\
+		rtw89_mmio_prof_record(rtwdev, _THIS_IP_, addr, true,	\
+				       __start);			\
+	} while (0)
+#else
+#define rtw89_mmio_prof_read(rtwdev, addr, access) (access)
+#define rtw89_mmio_prof_write(rtwdev, addr, access) access
+
+static inline bool rtw89_mmio_prof_tag(struct rtw89_dev *rtwdev,
+				       unsigned long ip)
 {
+	return false;
+}
+
+static inline void rtw89_mmio_prof_untag(struct rtw89_dev *rtwdev,
+					 bool tagged)
+{
+}
+#endif
+
+static __always_inline u8 __rtw89_read8(struct rtw89_dev *rtwdev, u32 addr)
+{
+	if (RTW89_HCI_DIRECT_IO && rtw89_hci_direct_read(addr))
+		return readb(rtwdev->hci.mmio + addr);
 	return rtwdev->hci.ops->read8(rtwdev, addr);
 }
 
-static inline u16 rtw89_read16(struct rtw89_dev *rtwdev, u32 addr)
+static __always_inline u16 __rtw89_read16(struct rtw89_dev *rtwdev, u32 addr)
 {
+	if (RTW89_HCI_DIRECT_IO && rtw89_hci_direct_read(addr))
+		return readw(rtwdev->hci.mmio + addr);
 	return rtwdev->hci.ops->read16(rtwdev, addr);
 }
 
-static inline u32 rtw89_read32(struct rtw89_dev *rtwdev, u32 addr)
+static __always_inline u32 __rtw89_read32(struct rtw89_dev *rtwdev, u32 addr)
 {
+	if (RTW89_HCI_DIRECT_IO && rtw89_hci_direct_read(addr))
+		return readl(rtwdev->hci.mmio + addr);
 	return rtwdev->hci.ops->read32(rtwdev, addr);
 }
 
-static inline void rtw89_write8(struct rtw89_dev *rtwdev, u32 addr, u8 data)
+static __always_inline void
+__rtw89_write8(struct rtw89_dev *rtwdev, u32 addr, u8 data)
 {
-	rtwdev->hci.ops->write8(rtwdev, addr, data);
+	if (RTW89_HCI_DIRECT_IO)
+		writeb(data, rtwdev->hci.mmio + addr);
+	else
+		rtwdev->hci.ops->write8(rtwdev, addr, data);
 }
 
-static inline void rtw89_write16(struct rtw89_dev *rtwdev, u32 addr, u16 data)
+static __always_inline void
+__rtw89_write16(struct rtw89_dev *rtwdev, u32 addr, u16 data)
 {
-	rtwdev->hci.ops->write16(rtwdev, addr, data);
+	if (RTW89_HCI_DIRECT_IO)
+		writew(data, rtwdev->hci.mmio + addr);
+	else
+		rtwdev->hci.ops->write16(rtwdev, addr, data);
 }
 
-static inline void rtw89_write32(struct rtw89_dev *rtwdev, u32 addr, u32 data)
+static __always_inline void
+__rtw89_write32(struct rtw89_dev *rtwdev, u32 addr, u32 data)
 {
-	rtwdev->hci.ops->write32(rtwdev, addr, data);
+	if (RTW89_HCI_DIRECT_IO)
+		writel(data, rtwdev->hci.mmio + addr);
+	else
+		rtwdev->hci.ops->write32(rtwdev, addr, data);
 }
 
-static inline void
+static __always_inline u8 rtw89_read8(struct rtw89_dev *rtwdev, u32 addr)
+{
+	return rtw89_mmio_prof_read(rtwdev, addr, __rtw89_read8(rtwdev, addr));
+}
+
+static __always_inline u16 rtw89_read16(struct rtw89_dev *rtwdev, u32 addr)
+{
+	return rtw89_mmio_prof_read(rtwdev, addr, __rtw89_read16(rtwdev, addr));
+}
+
+static __always_inline u32 rtw89_read32(struct rtw89_dev *rtwdev, u32 addr)
+{
+	return rtw89_mmio_prof_read(rtwdev, addr, __rtw89_read32(rtwdev, addr));
+}
+
+static __always_inline void
+rtw89_write8(struct rtw89_dev *rtwdev, u32 addr, u8 data)
+{
+	if (unlikely(rtwdev->shadow.enable))
+		rtw89_shadow_drop(rtwdev, addr);
+	rtw89_mmio_prof_write(rtwdev, addr, __rtw89_write8(rtwdev, addr, data));
+}
+
+static __always_inline void
+rtw89_write16(struct rtw89_dev *rtwdev, u32 addr, u16 data)
+{
+	if (unlikely(rtwdev->shadow.enable))
+		rtw89_shadow_drop(rtwdev, addr);
+	rtw89_mmio_prof_write(rtwdev, addr, __rtw89_write16(rtwdev, addr, data));
+}
+
+static __always_inline void
+rtw89_write32(struct rtw89_dev *rtwdev, u32 addr, u32 data)
+{
+	if (unlikely(rtwdev->shadow.enable))
+		rtw89_shadow_store(rtwdev, addr, data);
+	rtw89_mmio_prof_write(rtwdev, addr, __rtw89_write32(rtwdev, addr, data));
+}
+
+/* read for a read-modify-write, may be served from the shadow */
+static __always_inline u32 rtw89_read32_rmw(struct rtw89_dev *rtwdev, u32 addr)
+{
+	if (unlikely(rtwdev->shadow.enable))
+		return rtw89_shadow_load(rtwdev, addr);
+	return rtw89_read32(rtwdev, addr);
+}
+
+static __always_inline void
 rtw89_write8_set(struct rtw89_dev *rtwdev, u32 addr, u8 bit)
 {
 	u8 val;
@@ -2957,7 +3464,7 @@ rtw89_write8_set(struct rtw89_dev *rtwdev, u32 addr, u8 bit)
 	rtw89_write8(rtwdev, addr, val | bit);
 }
 
-static inline void
+static __always_inline void
 rtw89_write16_set(struct rtw89_dev *rtwdev, u32 addr, u16 bit)
 {
 	u16 val;
@@ -2966,16 +3473,16 @@ rtw89_write16_set(struct rtw89_dev *rtwdev, u32 addr, u16 bit)
 	rtw89_write16(rtwdev, addr, val | bit);
 }
 
-static inline void
+static __always_inline void
 rtw89_write32_set(struct rtw89_dev *rtwdev, u32 addr, u32 bit)
 {
 	u32 val;
 
-	val = rtw89_read32(rtwdev, addr);
+	val = rtw89_read32_rmw(rtwdev, addr);
 	rtw89_write32(rtwdev, addr, val | bit);
 }
 
-static inline void
+static __always_inline void
 rtw89_write8_clr(struct rtw89_dev *rtwdev, u32 addr, u8 bit)
 {
 	u8 val;
@@ -2984,7 +3491,7 @@ rtw89_write8_clr(struct rtw89_dev *rtwdev, u32 addr, u8 bit)
 	rtw89_write8(rtwdev, addr, val & ~bit);
 }
 
-static inline void
+static __always_inline void
 rtw89_write16_clr(struct rtw89_dev *rtwdev, u32 addr, u16 bit)
 {
 	u16 val;
@@ -2993,16 +3500,16 @@ rtw89_write16_clr(struct rtw89_dev *rtwdev, u32 addr, u16 bit)
 	rtw89_write16(rtwdev, addr, val & ~bit);
 }
 
-static inline void
+static __always_inline void
 rtw89_write32_clr(struct rtw89_dev *rtwdev, u32 addr, u32 bit)
 {
 	u32 val;
 
-	val = rtw89_read32(rtwdev, addr);
+	val = rtw89_read32_rmw(rtwdev, addr);
 	rtw89_write32(rtwdev, addr, val & ~bit);
 }
 
-static inline u32
+static __always_inline u32
 rtw89_read32_mask(struct rtw89_dev *rtwdev, u32 addr, u32 mask)
 {
 	u32 shift = __ffs(mask);
@@ -3015,7 +3522,7 @@ rtw89_read32_mask(struct rtw89_dev *rtwdev, u32 addr, u32 mask)
 	return ret;
 }
 
-static inline u16
+static __always_inline u16
 rtw89_read16_mask(struct rtw89_dev *rtwdev, u32 addr, u32 mask)
 {
 	u32 shift = __ffs(mask);
@@ -3028,7 +3535,7 @@ rtw89_read16_mask(struct rtw89_dev *rtwdev, u32 addr, u32 mask)
 	return ret;
 }
 
-static inline u8
+static __always_inline u8
 rtw89_read8_mask(struct rtw89_dev *rtwdev, u32 addr, u32 mask)
 {
 	u32 shift = __ffs(mask);
@@ -3041,7 +3548,7 @@ rtw89_read8_mask(struct rtw89_dev *rtwdev, u32 addr, u32 mask)
 	return ret;
 }
 
-static inline void
+static __always_inline void
 rtw89_write32_mask(struct rtw89_dev *rtwdev, u32 addr, u32 mask, u32 data)
 {
 	u32 shift = __ffs(mask);
@@ -3050,12 +3557,12 @@ rtw89_write32_mask(struct rtw89_dev *rtwdev, u32 addr, u32 mask, u32 data)
 
 	WARN(addr & 0x3, "should be 4-byte aligned, addr = 0x%08x\n", addr);
 
-	orig = rtw89_read32(rtwdev, addr);
+	orig = rtw89_read32_rmw(rtwdev, addr);
 	set = (orig & ~mask) | ((data << shift) & mask);
 	rtw89_write32(rtwdev, addr, set);
 }
 
-static inline void
+static __always_inline void
 rtw89_write16_mask(struct rtw89_dev *rtwdev, u32 addr, u32 mask, u16 data)
 {
 	u32 shift;
@@ -3069,7 +3576,7 @@ rtw89_write16_mask(struct rtw89_dev *rtwdev, u32 addr, u32 mask, u16 data)
 	rtw89_write16(rtwdev, addr, set);
 }
 
-static inline void
+static __always_inline void
 rtw89_write8_mask(struct rtw89_dev *rtwdev, u32 addr, u32 mask, u8 data)
 {
 	u32 shift;
@@ -3361,6 +3868,10 @@ static inline struct rtw89_fw_suit *rtw89_fw_suit_get(struct rtw89_dev *rtwdev,
 
 int rtw89_core_tx_write(struct rtw89_dev *rtwdev, struct ieee80211_vif *vif,
 			struct ieee80211_sta *sta, struct sk_buff *skb, int *qsel);
+void rtw89_core_h2c_txq_work(struct work_struct *work);
+void rtw89_core_h2c_txq_purge(struct rtw89_dev *rtwdev);
+bool rtw89_core_h2c_txq_flush(struct rtw89_dev *rtwdev);
+int rtw89_h2c_tx_fwdl(struct rtw89_dev *rtwdev, struct sk_buff *skb);
 int rtw89_h2c_tx(struct rtw89_dev *rtwdev,
 		 struct sk_buff *skb, bool fwdl);
 void rtw89_core_tx_kick_off(struct rtw89_dev *rtwdev, u8 qsel);
@@ -3374,6 +3885,8 @@ void rtw89_core_query_rxdesc(struct rtw89_dev *rtwdev,
 			     struct rtw89_rx_desc_info *desc_info,
 			     u8 *data, u32 data_offset);
 void rtw89_core_napi_start(struct rtw89_dev *rtwdev);
+void rtw89_core_stop_tx_ch(struct rtw89_dev *rtwdev, u8 ch_dma);
+void rtw89_core_wake_tx_ch(struct rtw89_dev *rtwdev, u8 ch_dma);
 void rtw89_core_napi_stop(struct rtw89_dev *rtwdev);
 void rtw89_core_napi_init(struct rtw89_dev *rtwdev);
 void rtw89_core_napi_deinit(struct rtw89_dev *rtwdev);
@@ -3394,6 +3907,18 @@ int rtw89_core_sta_remove(struct rtw89_dev *rtwdev,
 			  struct ieee80211_sta *sta);
 int rtw89_core_init(struct rtw89_dev *rtwdev);
 void rtw89_core_deinit(struct rtw89_dev *rtwdev);
+void rtw89_shadow_reset(struct rtw89_dev *rtwdev);
+void rtw89_reg_batch_write32_mask(struct rtw89_dev *rtwdev,
+				  struct rtw89_reg_batch *batch,
+				  u32 addr, u32 mask, u32 data);
+void rtw89_reg_batch_write32_set(struct rtw89_dev *rtwdev,
+				 struct rtw89_reg_batch *batch,
+				 u32 addr, u32 bits);
+void rtw89_reg_batch_write32_clr(struct rtw89_dev *rtwdev,
+				 struct rtw89_reg_batch *batch,
+				 u32 addr, u32 bits);
+void rtw89_reg_batch_flush(struct rtw89_dev *rtwdev,
+			   struct rtw89_reg_batch *batch);
 int rtw89_core_register(struct rtw89_dev *rtwdev);
 void rtw89_core_unregister(struct rtw89_dev *rtwdev);
 void rtw89_set_channel(struct rtw89_dev *rtwdev);
@@ -3408,8 +3933,11 @@ u16 rtw89_ra_report_to_bitrate(struct rtw89_dev *rtwdev, u8 rpt_rate);
 int rtw89_regd_init(struct rtw89_dev *rtwdev,
 		    void (*reg_notifier)(struct wiphy *wiphy, struct regulatory_request *request));
 void rtw89_regd_notifier(struct wiphy *wiphy, struct regulatory_request *request);
-void rtw89_traffic_stats_init(struct rtw89_dev *rtwdev,
-			      struct rtw89_traffic_stats *stats);
+int rtw89_traffic_stats_init(struct rtw89_dev *rtwdev,
+			     struct rtw89_traffic_stats *stats);
+void rtw89_traffic_stats_deinit(struct rtw89_dev *rtwdev,
+				struct rtw89_traffic_stats *stats);
+void rtw89_tx_ll_stats_done(struct rtw89_dev *rtwdev, bool acked, u32 lat_us);
 int rtw89_core_start(struct rtw89_dev *rtwdev);
 void rtw89_core_stop(struct rtw89_dev *rtwdev);
 
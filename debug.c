@@ -2,11 +2,15 @@
 /* Copyright(c) 2019-2020  Realtek Corporation
  */
 
+#include <linux/hash.h>
+#include <linux/relay.h>
+#include <linux/sort.h>
 #include <linux/version.h>
 #include "coex.h"
 #include "debug.h"
 #include "fw.h"
 #include "mac.h"
+#include "phy.h"
 #include "ps.h"
 #include "reg.h"
 #include "sar.h"
@@ -2373,6 +2377,642 @@ static int rtw89_debug_priv_phy_info_get(struct seq_file *m, void *v)
 	return 0;
 }
 
+static int rtw89_debug_priv_tx_flow_get(struct seq_file *m, void *v)
+{
+	static const char * const ac_names[IEEE80211_NUM_ACS] = {
+		[IEEE80211_AC_VO] = "VO",
+		[IEEE80211_AC_VI] = "VI",
+		[IEEE80211_AC_BE] = "BE",
+		[IEEE80211_AC_BK] = "BK",
+	};
+	struct rtw89_debugfs_priv *debugfs_priv = m->private;
+	struct rtw89_dev *rtwdev = debugfs_priv->rtwdev;
+	struct rtw89_tx_flow *tx_flow = &rtwdev->tx_flow;
+	const struct rtw89_tx_ll_stats *ll_stats;
+	u64 mgmt = 0, eapol = 0, acked = 0, failed = 0, lat_sum = 0;
+	u64 c_mgmt, c_eapol, c_acked, c_failed, c_lat_sum;
+	u32 lat_max = 0, c_lat_max;
+	unsigned int start;
+	u64 done;
+	int cpu, ac;
+
+	for (ac = 0; ac < IEEE80211_NUM_ACS; ac++)
+		seq_printf(m, "%s: %s stop=%u wake=%u drop=%u\n", ac_names[ac],
+			   test_bit(ac, &tx_flow->stopped) ? "stopped" : "running",
+			   tx_flow->stop_cnt[ac], tx_flow->wake_cnt[ac],
+			   tx_flow->drop_cnt[ac]);
+
+	for_each_possible_cpu(cpu) {
+		ll_stats = per_cpu_ptr(rtwdev->tx_ll_stats, cpu);
+		do {
+			start = u64_stats_fetch_begin(&ll_stats->syncp);
+			c_mgmt = u64_stats_read(&ll_stats->mgmt_cnt);
+			c_eapol = u64_stats_read(&ll_stats->eapol_cnt);
+			c_acked = u64_stats_read(&ll_stats->acked);
+			c_failed = u64_stats_read(&ll_stats->failed);
+			c_lat_sum = u64_stats_read(&ll_stats->lat_sum_us);
+			c_lat_max = ll_stats->lat_max_us;
+		} while (u64_stats_fetch_retry(&ll_stats->syncp, start));
+
+		mgmt += c_mgmt;
+		eapol += c_eapol;
+		acked += c_acked;
+		failed += c_failed;
+		lat_sum += c_lat_sum;
+		lat_max = max(lat_max, c_lat_max);
+	}
+
+	seq_printf(m, "MGMT: mgmt=%llu eapol=%llu acked=%llu failed=%llu",
+		   mgmt, eapol, acked, failed);
+	done = acked + failed;
+	seq_printf(m, " latency avg=%llu max=%u us\n",
+		   done ? div64_u64(lat_sum, done) : 0, lat_max);
+
+	return 0;
+}
+
+static int rtw89_debug_priv_fw_h2c_get(struct seq_file *m, void *v)
+{
+	static const char * const lat_names[RTW89_H2C_ACK_LAT_NUM] = {
+		[RTW89_H2C_ACK_LAT_100US] = "<100us",
+		[RTW89_H2C_ACK_LAT_500US] = "<500us",
+		[RTW89_H2C_ACK_LAT_1MS] = "<1ms",
+		[RTW89_H2C_ACK_LAT_5MS] = "<5ms",
+		[RTW89_H2C_ACK_LAT_20MS] = "<20ms",
+		[RTW89_H2C_ACK_LAT_SLOW] = ">=20ms",
+	};
+	static const char * const ack_names[RTW89_H2C_ACK_NUM] = {
+		[RTW89_H2C_ACK_REC] = "rec",
+		[RTW89_H2C_ACK_DONE] = "done",
+	};
+	struct rtw89_debugfs_priv *debugfs_priv = m->private;
+	struct rtw89_dev *rtwdev = debugfs_priv->rtwdev;
+	struct rtw89_h2c_ack_info *ack = &rtwdev->fw.h2c_ack;
+	struct rtw89_h2c_txq *h2c_txq = &rtwdev->fw.h2c_txq;
+	struct rtw89_fw_reg_mbox *mbox = &rtwdev->fw.reg_mbox;
+	struct rtw89_h2c_arena *arena = &rtwdev->fw.h2c_arena;
+	int type, i;
+
+	spin_lock_bh(&ack->lock);
+	seq_printf(m, "h2c_seq=%u outstanding=%u lost=%u timeout=%u\n",
+		   rtwdev->fw.h2c_seq, ack->outstanding, ack->lost,
+		   ack->timeout);
+	for (type = 0; type < RTW89_H2C_ACK_NUM; type++) {
+		seq_printf(m, "%-4s ack:", ack_names[type]);
+		for (i = 0; i < RTW89_H2C_ACK_LAT_NUM; i++)
+			seq_printf(m, " %s=%u", lat_names[i], ack->hist[type][i]);
+		seq_printf(m, " max=%uus\n", ack->lat_max_us[type]);
+	}
+	spin_unlock_bh(&ack->lock);
+
+	spin_lock_bh(&arena->lock);
+	seq_printf(m, "arena: bufs=%d len=%d hit=%u miss=%u\n",
+		   RTW89_H2C_ARENA_NUM, RTW89_H2C_ARENA_BUF_LEN,
+		   arena->hit, arena->miss);
+	spin_unlock_bh(&arena->lock);
+
+	seq_printf(m, "reg mbox: irq=%u poll=%u fail=%u rtt avg=%lluus max=%uus\n",
+		   mbox->irq_cnt, mbox->poll_cnt, mbox->fail_cnt,
+		   mbox->rtt_cnt ? div_u64(mbox->rtt_sum_us, mbox->rtt_cnt) : 0,
+		   mbox->rtt_max_us);
+
+	spin_lock_bh(&h2c_txq->lock);
+	seq_printf(m, "txq: depth=%u max_depth=%u queued=%u stalls=%u dropped=%u\n",
+		   skb_queue_len(&h2c_txq->queue), h2c_txq->max_depth,
+		   h2c_txq->queued, h2c_txq->stalls, h2c_txq->dropped);
+	spin_unlock_bh(&h2c_txq->lock);
+
+	return 0;
+}
+
+static int rtw89_debug_priv_fw_dl_get(struct seq_file *m, void *v)
+{
+	struct rtw89_debugfs_priv *debugfs_priv = m->private;
+	struct rtw89_dev *rtwdev = debugfs_priv->rtwdev;
+	struct rtw89_fw_dl_stats *dl_stats = &rtwdev->fw.dl_stats;
+	struct rtw89_fw_dl_section_stats *stats;
+	int i;
+
+	seq_printf(m, "download count: %u\n", dl_stats->dl_cnt);
+	seq_printf(m, "last: total=%uus hdr=%uus rdy=%uus credit_wait=%u\n",
+		   dl_stats->total_us, dl_stats->hdr_us, dl_stats->rdy_us,
+		   dl_stats->credit_wait_cnt);
+	seq_printf(m, "chunks: reused=%u copied=%u\n", dl_stats->chunk_reused,
+		   dl_stats->chunk_copied);
+
+	for (i = 0; i < dl_stats->section_num && i < FWDL_SECTION_MAX_NUM; i++) {
+		stats = &dl_stats->section[i];
+		seq_printf(m, "section %d: len=%u pkt=%u kick=%u time=%uus\n",
+			   i, stats->len, stats->pkt_cnt, stats->kick_cnt,
+			   stats->time_us);
+	}
+
+	return 0;
+}
+
+static int rtw89_debug_priv_fw_c2h_get(struct seq_file *m, void *v)
+{
+	struct rtw89_debugfs_priv *debugfs_priv = m->private;
+	struct rtw89_dev *rtwdev = debugfs_priv->rtwdev;
+	struct rtw89_c2h_stats *stats = &rtwdev->fw.c2h_stats;
+	struct rtw89_c2h_class_stats *cls;
+	int cat, class;
+
+	seq_printf(m, "batch=%u max_batch=%u atomic=%u locked=%u\n",
+		   stats->batch_cnt, stats->max_batch, stats->atomic_cnt,
+		   stats->locked_cnt);
+
+	for (cat = 0; cat < RTW89_C2H_STATS_CAT_NUM; cat++) {
+		for (class = 0; class < RTW89_C2H_STATS_CLASS_NUM; class++) {
+			cls = &stats->cls[cat][class];
+			if (!cls->cnt)
+				continue;
+			seq_printf(m, "cat %d class 0x%02x: cnt=%u avg=%lluus max=%uus\n",
+				   cat, class, cls->cnt,
+				   div_u64(cls->total_us, cls->cnt), cls->max_us);
+		}
+	}
+
+	return 0;
+}
+
+static int rtw89_debug_priv_fw_log_relay_get(struct seq_file *m, void *v)
+{
+	struct rtw89_debugfs_priv *debugfs_priv = m->private;
+	struct rtw89_dev *rtwdev = debugfs_priv->rtwdev;
+	struct rtw89_fw_log_relay *relay = &rtwdev->fw.log_relay;
+
+	spin_lock_bh(&relay->lock);
+	seq_printf(m, "relay: %s\n", relay->rchan ? "on" : "off");
+	seq_printf(m, "records: %u dropped: %u bytes: %llu next seq: %u\n",
+		   relay->rec_cnt, relay->drop_cnt, relay->bytes, relay->seq);
+	spin_unlock_bh(&relay->lock);
+
+	return 0;
+}
+
+static void rtw89_debug_phy_flat_table(struct seq_file *m, const char *name,
+				       struct rtw89_phy_flat_table *flat)
+{
+	seq_printf(m, "%-6s %s src=%u flat=%u dropped=%u walk=%uus replays=%u last: wall=%uus cpu=%uus sleep=%uus\n",
+		   name, flat->regs ? "flat" : "walk", flat->n_src,
+		   flat->n_regs, flat->n_dropped, flat->walk_us,
+		   flat->replay_cnt, flat->replay_us, flat->cpu_us,
+		   flat->sleep_us);
+}
+
+static int rtw89_debug_priv_phy_tables_get(struct seq_file *m, void *v)
+{
+	struct rtw89_debugfs_priv *debugfs_priv = m->private;
+	struct rtw89_dev *rtwdev = debugfs_priv->rtwdev;
+	struct rtw89_phy_flat_tables *tables = &rtwdev->phy_flat;
+	struct rtw89_phy_tbl_blob *blob = &rtwdev->tbl_blob;
+	const char * const rf_name[RF_PATH_MAX] = {"rf_a", "rf_b", "rf_c", "rf_d"};
+	int n_tbl = 0;
+	u8 path;
+	int i;
+
+	rtw89_debug_phy_flat_table(m, "bb", &tables->bb);
+	for (path = RF_PATH_A; path < rtwdev->chip->rf_path_num; path++)
+		rtw89_debug_phy_flat_table(m, rf_name[path], &tables->rf[path]);
+	rtw89_debug_phy_flat_table(m, "nctl", &tables->nctl);
+
+	if (!blob->firmware) {
+		seq_puts(m, "blob   none, built-in tables\n");
+		return 0;
+	}
+
+	for (i = 0; i < RTW89_TBL_PHY_NUM; i++)
+		n_tbl += !!blob->phy[i].packed;
+	for (i = 0; i < RTW89_TBL_LMT_NUM; i++)
+		n_tbl += !!blob->lmt[i].rows;
+
+	seq_printf(m, "blob   %s version=%u size=%zu tables=%d load=%uus\n",
+		   rtwdev->chip->table_name, blob->version,
+		   blob->firmware->size, n_tbl, blob->load_us);
+
+	return 0;
+}
+
+static int rtw89_debug_priv_shadow_regs_get(struct seq_file *m, void *v)
+{
+	struct rtw89_debugfs_priv *debugfs_priv = m->private;
+	struct rtw89_dev *rtwdev = debugfs_priv->rtwdev;
+	struct rtw89_shadow_regs *shadow = &rtwdev->shadow;
+
+	seq_printf(m, "enable=%d verify=%d regs=%u cached=%u\n",
+		   shadow->enable, shadow->verify, shadow->n_regs,
+		   shadow->valid ? bitmap_weight(shadow->valid, shadow->n_regs) : 0);
+	seq_printf(m, "hit=%u miss=%u mismatch=%u\n",
+		   shadow->hit, shadow->miss, shadow->mismatch);
+
+	return 0;
+}
+
+static ssize_t rtw89_debug_priv_shadow_regs_set(struct file *filp,
+						const char __user *user_buf,
+						size_t count, loff_t *loff)
+{
+	struct seq_file *m = (struct seq_file *)filp->private_data;
+	struct rtw89_debugfs_priv *debugfs_priv = m->private;
+	struct rtw89_dev *rtwdev = debugfs_priv->rtwdev;
+	struct rtw89_shadow_regs *shadow = &rtwdev->shadow;
+	char buf[32];
+	size_t buf_size;
+	int enable, verify;
+	int num;
+
+	buf_size = min(count, sizeof(buf) - 1);
+	if (copy_from_user(buf, user_buf, buf_size))
+		return -EFAULT;
+
+	buf[buf_size] = '\0';
+	num = sscanf(buf, "%d %d", &enable, &verify);
+	if (num != 2) {
+		rtw89_info(rtwdev, "invalid format: <enable> <verify>\n");
+		return -EINVAL;
+	}
+
+	if (!shadow->n_regs)
+		return -EOPNOTSUPP;
+
+	mutex_lock(&rtwdev->mutex);
+	shadow->enable = false;
+	rtw89_shadow_reset(rtwdev);
+	shadow->hit = 0;
+	shadow->miss = 0;
+	shadow->mismatch = 0;
+	shadow->verify = !!verify;
+	shadow->enable = !!enable;
+	mutex_unlock(&rtwdev->mutex);
+
+	return count;
+}
+
+#define RTW89_HCI_BENCH_LOOPS 1000
+
+static u64 rtw89_hci_bench_read(struct rtw89_dev *rtwdev, u32 addr, bool direct)
+{
+	u64 start;
+	u32 i;
+
+	start = ktime_get_ns();
+	if (direct) {
+		for (i = 0; i < RTW89_HCI_BENCH_LOOPS; i++)
+			rtw89_read32(rtwdev, addr);
+	} else {
+		for (i = 0; i < RTW89_HCI_BENCH_LOOPS; i++)
+			rtwdev->hci.ops->read32(rtwdev, addr);
+	}
+
+	return ktime_get_ns() - start;
+}
+
+static u64 rtw89_hci_bench_write(struct rtw89_dev *rtwdev, u32 addr, u32 val,
+				 bool direct)
+{
+	u64 start;
+	u32 i;
+
+	start = ktime_get_ns();
+	if (direct) {
+		for (i = 0; i < RTW89_HCI_BENCH_LOOPS; i++)
+			rtw89_write32(rtwdev, addr, val);
+	} else {
+		for (i = 0; i < RTW89_HCI_BENCH_LOOPS; i++)
+			rtwdev->hci.ops->write32(rtwdev, addr, val);
+	}
+	/* flush posted writes so they are part of the measurement */
+	rtw89_read32(rtwdev, addr);
+
+	return ktime_get_ns() - start;
+}
+
+static int rtw89_debug_priv_hci_bench_get(struct seq_file *m, void *v)
+{
+	struct rtw89_debugfs_priv *debugfs_priv = m->private;
+	struct rtw89_dev *rtwdev = debugfs_priv->rtwdev;
+	u64 rd_ops, rd_direct, wr_ops, wr_direct;
+	u32 addr = R_AX_DBG_PORT_SEL;
+	u32 val;
+
+	mutex_lock(&rtwdev->mutex);
+	if (!test_bit(RTW89_FLAG_POWERON, rtwdev->flags)) {
+		mutex_unlock(&rtwdev->mutex);
+		seq_puts(m, "power off\n");
+		return 0;
+	}
+
+	/* write back the current value so the benchmark changes nothing */
+	val = rtw89_read32(rtwdev, addr);
+	local_bh_disable();
+	rd_ops = rtw89_hci_bench_read(rtwdev, addr, false);
+	rd_direct = rtw89_hci_bench_read(rtwdev, addr, true);
+	wr_ops = rtw89_hci_bench_write(rtwdev, addr, val, false);
+	wr_direct = rtw89_hci_bench_write(rtwdev, addr, val, true);
+	local_bh_enable();
+	mutex_unlock(&rtwdev->mutex);
+
+	seq_printf(m, "accessors: %s, %u accesses of %#x each\n",
+		   RTW89_HCI_DIRECT_IO ? "direct" : "hci ops",
+		   RTW89_HCI_BENCH_LOOPS, addr);
+	seq_printf(m, "read32:  hci ops %llu ns, rtw89_read32 %llu ns\n",
+		   div_u64(rd_ops, RTW89_HCI_BENCH_LOOPS),
+		   div_u64(rd_direct, RTW89_HCI_BENCH_LOOPS));
+	seq_printf(m, "write32: hci ops %llu ns, rtw89_write32 %llu ns\n",
+		   div_u64(wr_ops, RTW89_HCI_BENCH_LOOPS),
+		   div_u64(wr_direct, RTW89_HCI_BENCH_LOOPS));
+
+	return 0;
+}
+
+#ifdef CONFIG_RTW89_MMIO_PROF
+#define RTW89_MMIO_PROF_SITE_BITS 8
+#define RTW89_MMIO_PROF_SITES BIT(RTW89_MMIO_PROF_SITE_BITS)
+#define RTW89_MMIO_PROF_RF_SIZE 0x400
+
+enum rtw89_mmio_prof_range {
+	RTW89_MMIO_PROF_MAC,
+	RTW89_MMIO_PROF_BB,
+	RTW89_MMIO_PROF_RF,
+
+	RTW89_MMIO_PROF_RANGE_NUM,
+};
+
+static const char * const rtw89_mmio_prof_range_name[] = {
+	[RTW89_MMIO_PROF_MAC] = "mac",
+	[RTW89_MMIO_PROF_BB] = "bb",
+	[RTW89_MMIO_PROF_RF] = "rf",
+};
+
+struct rtw89_mmio_prof_stat {
+	u64 cnt;
+	u64 total_ns;
+	u32 max_ns;
+};
+
+struct rtw89_mmio_prof_site {
+	unsigned long ip;
+	/* indexed by write */
+	struct rtw89_mmio_prof_stat stat[2];
+};
+
+struct rtw89_mmio_prof {
+	/* accesses come from the interrupt handler as well */
+	spinlock_t lock;
+	struct rtw89_mmio_prof_stat range[RTW89_MMIO_PROF_RANGE_NUM][2];
+	struct rtw89_mmio_prof_site sites[RTW89_MMIO_PROF_SITES];
+	u32 n_sites;
+	/* accesses from call sites that did not fit in the table */
+	u64 untracked;
+	/* task inside a tagged helper, and the call site it reports */
+	struct task_struct *tag_task;
+	unsigned long tag_ip;
+};
+
+void rtw89_mmio_prof_init(struct rtw89_dev *rtwdev)
+{
+	struct rtw89_mmio_prof *prof;
+
+	prof = vzalloc(sizeof(*prof));
+	if (!prof) {
+		rtw89_warn(rtwdev, "failed to allocate mmio profiler\n");
+		return;
+	}
+
+	spin_lock_init(&prof->lock);
+	rtwdev->mmio_prof = prof;
+}
+
+void rtw89_mmio_prof_deinit(struct rtw89_dev *rtwdev)
+{
+	struct rtw89_mmio_prof *prof = rtwdev->mmio_prof;
+
+	rtwdev->mmio_prof = NULL;
+	vfree(prof);
+}
+
+static enum rtw89_mmio_prof_range
+rtw89_mmio_prof_range(struct rtw89_dev *rtwdev, u32 addr)
+{
+	const struct rtw89_chip_info *chip = rtwdev->chip;
+	u32 base;
+	u8 path;
+
+	if (addr < RTW89_PHY_ADDR_OFFSET)
+		return RTW89_MMIO_PROF_MAC;
+
+	for (path = RF_PATH_A; path < chip->rf_path_num; path++) {
+		base = chip->rf_base_addr[path] | RTW89_PHY_ADDR_OFFSET;
+		if (addr >= base && addr < base + RTW89_MMIO_PROF_RF_SIZE)
+			return RTW89_MMIO_PROF_RF;
+	}
+
+	return RTW89_MMIO_PROF_BB;
+}
+
+static struct rtw89_mmio_prof_site *
+rtw89_mmio_prof_site(struct rtw89_mmio_prof *prof, unsigned long ip)
+{
+	struct rtw89_mmio_prof_site *site;
+	u32 idx = hash_long(ip, RTW89_MMIO_PROF_SITE_BITS);
+	u32 i;
+
+	for (i = 0; i < RTW89_MMIO_PROF_SITES; i++) {
+		site = &prof->sites[(idx + i) % RTW89_MMIO_PROF_SITES];
+		if (site->ip == ip)
+			return site;
+		if (!site->ip) {
+			site->ip = ip;
+			prof->n_sites++;
+			return site;
+		}
+	}
+
+	return NULL;
+}
+
+static void rtw89_mmio_prof_add(struct rtw89_mmio_prof_stat *stat, u32 ns)
+{
+	stat->cnt++;
+	stat->total_ns += ns;
+	if (ns > stat->max_ns)
+		stat->max_ns = ns;
+}
+
+void rtw89_mmio_prof_record(struct rtw89_dev *rtwdev, unsigned long ip,
+			    u32 addr, bool write, u64 start_ns)
+{
+	struct rtw89_mmio_prof *prof = rtwdev->mmio_prof;
+	struct rtw89_mmio_prof_site *site;
+	enum rtw89_mmio_prof_range range;
+	unsigned long flags;
+	u32 ns;
+
+	if (!prof)
+		return;
+
+	ns = min_t(u64, ktime_get_ns() - start_ns, U32_MAX);
+	range = rtw89_mmio_prof_range(rtwdev, addr);
+
+	spin_lock_irqsave(&prof->lock, flags);
+	if (prof->tag_task == current && in_task())
+		ip = prof->tag_ip;
+	rtw89_mmio_prof_add(&prof->range[range][write], ns);
+	site = rtw89_mmio_prof_site(prof, ip);
+	if (site)
+		rtw89_mmio_prof_add(&site->stat[write], ns);
+	else
+		prof->untracked++;
+	spin_unlock_irqrestore(&prof->lock, flags);
+}
+EXPORT_SYMBOL(rtw89_mmio_prof_record);
+
+/* Report the accesses of the current task as made from ip until untagged,
+ * so that shared helpers do not show up as the call site. The outermost
+ * tag wins; accesses from interrupts and other tasks are not affected.
+ */
+bool rtw89_mmio_prof_tag(struct rtw89_dev *rtwdev, unsigned long ip)
+{
+	struct rtw89_mmio_prof *prof = rtwdev->mmio_prof;
+	unsigned long flags;
+	bool tagged = false;
+
+	if (!prof || !in_task())
+		return false;
+
+	spin_lock_irqsave(&prof->lock, flags);
+	if (!prof->tag_task) {
+		prof->tag_task = current;
+		prof->tag_ip = ip;
+		tagged = true;
+	}
+	spin_unlock_irqrestore(&prof->lock, flags);
+
+	return tagged;
+}
+EXPORT_SYMBOL(rtw89_mmio_prof_tag);
+
+void rtw89_mmio_prof_untag(struct rtw89_dev *rtwdev, bool tagged)
+{
+	struct rtw89_mmio_prof *prof = rtwdev->mmio_prof;
+	unsigned long flags;
+
+	if (!prof || !tagged)
+		return;
+
+	spin_lock_irqsave(&prof->lock, flags);
+	prof->tag_task = NULL;
+	spin_unlock_irqrestore(&prof->lock, flags);
+}
+EXPORT_SYMBOL(rtw89_mmio_prof_untag);
+
+static int rtw89_mmio_prof_site_cmp(const void *a, const void *b)
+{
+	const struct rtw89_mmio_prof_site *sa = a, *sb = b;
+	u64 ta = sa->stat[0].total_ns + sa->stat[1].total_ns;
+	u64 tb = sb->stat[0].total_ns + sb->stat[1].total_ns;
+
+	if (ta == tb)
+		return 0;
+	return ta < tb ? 1 : -1;
+}
+
+static void rtw89_mmio_prof_print(struct seq_file *m, const char *name,
+				  const struct rtw89_mmio_prof_stat *stat)
+{
+	seq_printf(m, " %-2s cnt=%llu total=%lluus avg=%lluns max=%uns",
+		   name, stat->cnt, div_u64(stat->total_ns, NSEC_PER_USEC),
+		   stat->cnt ? div64_u64(stat->total_ns, stat->cnt) : 0,
+		   stat->max_ns);
+}
+
+static int rtw89_debug_priv_mmio_prof_get(struct seq_file *m, void *v)
+{
+	struct rtw89_debugfs_priv *debugfs_priv = m->private;
+	struct rtw89_dev *rtwdev = debugfs_priv->rtwdev;
+	struct rtw89_mmio_prof *prof = rtwdev->mmio_prof;
+	struct rtw89_mmio_prof_site *sites;
+	struct rtw89_mmio_prof_site *site;
+	unsigned long flags;
+	u32 n_sites, i;
+
+	if (!prof)
+		return -EOPNOTSUPP;
+
+	sites = vmalloc(sizeof(prof->sites));
+	if (!sites)
+		return -ENOMEM;
+
+	spin_lock_irqsave(&prof->lock, flags);
+	for (i = 0; i < RTW89_MMIO_PROF_RANGE_NUM; i++) {
+		seq_printf(m, "%-4s", rtw89_mmio_prof_range_name[i]);
+		rtw89_mmio_prof_print(m, "rd", &prof->range[i][0]);
+		rtw89_mmio_prof_print(m, "wr", &prof->range[i][1]);
+		seq_puts(m, "\n");
+	}
+	seq_printf(m, "call sites: %u, untracked accesses: %llu\n\n",
+		   prof->n_sites, prof->untracked);
+	memcpy(sites, prof->sites, sizeof(prof->sites));
+	spin_unlock_irqrestore(&prof->lock, flags);
+
+	for (i = 0, n_sites = 0; i < RTW89_MMIO_PROF_SITES; i++)
+		if (sites[i].ip)
+			sites[n_sites++] = sites[i];
+	sort(sites, n_sites, sizeof(*sites), rtw89_mmio_prof_site_cmp, NULL);
+
+	for (i = 0; i < n_sites; i++) {
+		site = &sites[i];
+		seq_printf(m, "%pS\n", (void *)site->ip);
+		if (site->stat[0].cnt)
+			rtw89_mmio_prof_print(m, "rd", &site->stat[0]);
+		if (site->stat[1].cnt)
+			rtw89_mmio_prof_print(m, "wr", &site->stat[1]);
+		seq_puts(m, "\n");
+	}
+
+	vfree(sites);
+
+	return 0;
+}
+
+static ssize_t rtw89_debug_priv_mmio_prof_set(struct file *filp,
+					      const char __user *user_buf,
+					      size_t count, loff_t *loff)
+{
+	struct seq_file *m = (struct seq_file *)filp->private_data;
+	struct rtw89_debugfs_priv *debugfs_priv = m->private;
+	struct rtw89_dev *rtwdev = debugfs_priv->rtwdev;
+	struct rtw89_mmio_prof *prof = rtwdev->mmio_prof;
+	unsigned long flags;
+	char buf[32];
+	size_t buf_size;
+	int reset;
+
+	buf_size = min(count, sizeof(buf) - 1);
+	if (copy_from_user(buf, user_buf, buf_size))
+		return -EFAULT;
+
+	buf[buf_size] = '\0';
+	if (kstrtoint(buf, 0, &reset) || reset != 0) {
+		rtw89_info(rtwdev, "write 0 to reset the profile\n");
+		return -EINVAL;
+	}
+
+	if (!prof)
+		return -EOPNOTSUPP;
+
+	spin_lock_irqsave(&prof->lock, flags);
+	memset(prof->range, 0, sizeof(prof->range));
+	memset(prof->sites, 0, sizeof(prof->sites));
+	prof->n_sites = 0;
+	prof->untracked = 0;
+	spin_unlock_irqrestore(&prof->lock, flags);
+
+	return count;
+}
+#endif
+
 static void rtw89_dump_addr_cam(struct seq_file *m,
 				struct rtw89_addr_cam_entry *addr_cam)
 {
@@ -2509,6 +3149,156 @@ static struct rtw89_debugfs_priv rtw89_debug_priv_stations = {
 	.cb_read = rtw89_debug_priv_stations_get,
 };
 
+static struct rtw89_debugfs_priv rtw89_debug_priv_tx_flow = {
+	.cb_read = rtw89_debug_priv_tx_flow_get,
+};
+
+static struct rtw89_debugfs_priv rtw89_debug_priv_fw_h2c = {
+	.cb_read = rtw89_debug_priv_fw_h2c_get,
+};
+
+static struct rtw89_debugfs_priv rtw89_debug_priv_fw_dl = {
+	.cb_read = rtw89_debug_priv_fw_dl_get,
+};
+
+static struct rtw89_debugfs_priv rtw89_debug_priv_fw_c2h = {
+	.cb_read = rtw89_debug_priv_fw_c2h_get,
+};
+
+static struct rtw89_debugfs_priv rtw89_debug_priv_fw_log_relay = {
+	.cb_read = rtw89_debug_priv_fw_log_relay_get,
+};
+
+static struct rtw89_debugfs_priv rtw89_debug_priv_phy_tables = {
+	.cb_read = rtw89_debug_priv_phy_tables_get,
+};
+
+static struct rtw89_debugfs_priv rtw89_debug_priv_shadow_regs = {
+	.cb_read = rtw89_debug_priv_shadow_regs_get,
+	.cb_write = rtw89_debug_priv_shadow_regs_set,
+};
+
+static struct rtw89_debugfs_priv rtw89_debug_priv_hci_bench = {
+	.cb_read = rtw89_debug_priv_hci_bench_get,
+};
+
+#ifdef CONFIG_RTW89_MMIO_PROF
+static struct rtw89_debugfs_priv rtw89_debug_priv_mmio_prof = {
+	.cb_read = rtw89_debug_priv_mmio_prof_get,
+	.cb_write = rtw89_debug_priv_mmio_prof_set,
+};
+#endif
+
+#define RTW89_FW_LOG_REC_MAGIC 0x8952
+#define RTW89_FW_LOG_SUBBUF_SIZE 16384
+#define RTW89_FW_LOG_SUBBUF_NUM 8
+
+/* Record layout of the fw_log relay file, decoded by fw_log_decode.py. The
+ * sequence number also advances for dropped records, so gaps are visible.
+ */
+struct rtw89_fw_log_rec_hdr {
+	__le16 magic;
+	__le16 len;
+	__le32 seq;
+	__le64 ts_ns;
+	__le32 drop_cnt;
+} __packed;
+
+bool rtw89_fw_log_relay(struct rtw89_dev *rtwdev, const void *data, u16 len)
+{
+	struct rtw89_fw_log_relay *relay = &rtwdev->fw.log_relay;
+	struct rtw89_fw_log_rec_hdr *hdr;
+	bool relayed = false;
+
+	spin_lock_bh(&relay->lock);
+	if (!relay->rchan)
+		goto out;
+
+	relayed = true;
+	hdr = relay_reserve(relay->rchan, sizeof(*hdr) + len);
+	if (!hdr) {
+		relay->drop_cnt++;
+		relay->seq++;
+		goto out;
+	}
+
+	hdr->magic = cpu_to_le16(RTW89_FW_LOG_REC_MAGIC);
+	hdr->len = cpu_to_le16(len);
+	hdr->seq = cpu_to_le32(relay->seq++);
+	/* same clock as printk, so records line up with the kernel log */
+	hdr->ts_ns = cpu_to_le64(local_clock());
+	hdr->drop_cnt = cpu_to_le32(relay->drop_cnt);
+	memcpy(hdr + 1, data, len);
+
+	relay->rec_cnt++;
+	relay->bytes += len;
+out:
+	spin_unlock_bh(&relay->lock);
+
+	return relayed;
+}
+
+static struct dentry *rtw89_fw_log_create_buf_file(const char *filename,
+						   struct dentry *parent,
+						   umode_t mode,
+						   struct rchan_buf *buf,
+						   int *is_global)
+{
+	*is_global = 1;
+
+	return debugfs_create_file(filename, mode, parent, buf,
+				   &relay_file_operations);
+}
+
+static int rtw89_fw_log_remove_buf_file(struct dentry *dentry)
+{
+	debugfs_remove(dentry);
+
+	return 0;
+}
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 11, 0)
+static const struct rchan_callbacks rtw89_fw_log_relay_cb = {
+#else
+static struct rchan_callbacks rtw89_fw_log_relay_cb = {
+#endif
+	.create_buf_file = rtw89_fw_log_create_buf_file,
+	.remove_buf_file = rtw89_fw_log_remove_buf_file,
+};
+
+static void rtw89_fw_log_relay_init(struct rtw89_dev *rtwdev,
+				    struct dentry *parent)
+{
+	struct rtw89_fw_log_relay *relay = &rtwdev->fw.log_relay;
+	struct rchan *rchan;
+
+	rchan = relay_open("fw_log", parent, RTW89_FW_LOG_SUBBUF_SIZE,
+			   RTW89_FW_LOG_SUBBUF_NUM,
+			   &rtw89_fw_log_relay_cb, rtwdev);
+	if (!rchan) {
+		rtw89_warn(rtwdev, "failed to open fw log relay\n");
+		return;
+	}
+
+	spin_lock_bh(&relay->lock);
+	relay->rchan = rchan;
+	spin_unlock_bh(&relay->lock);
+}
+
+void rtw89_debugfs_deinit(struct rtw89_dev *rtwdev)
+{
+	struct rtw89_fw_log_relay *relay = &rtwdev->fw.log_relay;
+	struct rchan *rchan;
+
+	spin_lock_bh(&relay->lock);
+	rchan = relay->rchan;
+	relay->rchan = NULL;
+	spin_unlock_bh(&relay->lock);
+
+	if (rchan)
+		relay_close(rchan);
+}
+
 #define rtw89_debugfs_add(name, mode, fopname, parent)				\
 	do {									\
 		rtw89_debug_priv_ ##name.rtwdev = rtwdev;			\
@@ -2548,6 +3338,18 @@ void rtw89_debugfs_init(struct rtw89_dev *rtwdev)
 	rtw89_debugfs_add_w(fw_log_manual);
 	rtw89_debugfs_add_r(phy_info);
 	rtw89_debugfs_add_r(stations);
+	rtw89_debugfs_add_r(tx_flow);
+	rtw89_debugfs_add_r(fw_h2c);
+	rtw89_debugfs_add_r(fw_dl);
+	rtw89_debugfs_add_r(fw_c2h);
+	rtw89_debugfs_add_r(fw_log_relay);
+	rtw89_debugfs_add_r(phy_tables);
+	rtw89_debugfs_add_rw(shadow_regs);
+	rtw89_debugfs_add_r(hci_bench);
+#ifdef CONFIG_RTW89_MMIO_PROF
+	rtw89_debugfs_add_rw(mmio_prof);
+#endif
+	rtw89_fw_log_relay_init(rtwdev, debugfs_topdir);
 }
 #endif
 
@@ -38,8 +38,27 @@ enum rtw89_debug_mac_reg_sel {
 
 #ifdef CONFIG_RTW89_DEBUGFS
 void rtw89_debugfs_init(struct rtw89_dev *rtwdev);
+void rtw89_debugfs_deinit(struct rtw89_dev *rtwdev);
+bool rtw89_fw_log_relay(struct rtw89_dev *rtwdev, const void *data, u16 len);
 #else
 static inline void rtw89_debugfs_init(struct rtw89_dev *rtwdev) {}
+static inline void rtw89_debugfs_deinit(struct rtw89_dev *rtwdev) {}
+static inline bool rtw89_fw_log_relay(struct rtw89_dev *rtwdev,
+				      const void *data, u16 len)
+{
+	return false;
+}
+#endif
+
+#ifdef CONFIG_RTW89_MMIO_PROF
+#ifndef CONFIG_RTW89_DEBUGFS
+#error "CONFIG_RTW89_MMIO_PROF needs CONFIG_RTW89_DEBUGFS"
+#endif
+void rtw89_mmio_prof_init(struct rtw89_dev *rtwdev);
+void rtw89_mmio_prof_deinit(struct rtw89_dev *rtwdev);
+#else
+static inline void rtw89_mmio_prof_init(struct rtw89_dev *rtwdev) {}
+static inline void rtw89_mmio_prof_deinit(struct rtw89_dev *rtwdev) {}
 #endif
 
 #define rtw89_info(rtwdev, a...) dev_info((rtwdev)->dev, ##a)
@@ -37,6 +37,80 @@ struct sk_buff *rtw89_fw_h2c_alloc_skb_no_hdr(u32 len)
 	return rtw89_fw_h2c_alloc_skb(len, false);
 }
 
+int rtw89_fw_h2c_arena_init(struct rtw89_dev *rtwdev)
+{
+	struct rtw89_h2c_arena *arena = &rtwdev->fw.h2c_arena;
+	struct sk_buff *skb;
+	int i;
+
+	spin_lock_init(&arena->lock);
+
+	for (i = 0; i < RTW89_H2C_ARENA_NUM; i++) {
+		skb = dev_alloc_skb(RTW89_H2C_ARENA_HEADROOM +
+				    RTW89_H2C_ARENA_BUF_LEN);
+		if (!skb) {
+			rtw89_fw_h2c_arena_deinit(rtwdev);
+			return -ENOMEM;
+		}
+		skb_reserve(skb, RTW89_H2C_ARENA_HEADROOM);
+		arena->bufs[i] = skb;
+	}
+	arena->headroom = skb_headroom(arena->bufs[0]);
+
+	return 0;
+}
+
+void rtw89_fw_h2c_arena_deinit(struct rtw89_dev *rtwdev)
+{
+	struct rtw89_h2c_arena *arena = &rtwdev->fw.h2c_arena;
+	int i;
+
+	/* buffers still owned by the HCI are freed when it drops them */
+	for (i = 0; i < RTW89_H2C_ARENA_NUM; i++) {
+		dev_kfree_skb_any(arena->bufs[i]);
+		arena->bufs[i] = NULL;
+	}
+}
+
+/* Same contract as rtw89_fw_h2c_alloc_skb_with_hdr(), but the buffer comes
+ * from the per-device arena. The arena keeps a reference of its own, so the
+ * buffer is recycled instead of freed once the HCI has released it.
+ */
+struct sk_buff *rtw89_fw_h2c_arena_alloc(struct rtw89_dev *rtwdev, u32 len)
+{
+	struct rtw89_h2c_arena *arena = &rtwdev->fw.h2c_arena;
+	struct sk_buff *skb = NULL;
+	u8 idx;
+	int i;
+
+	spin_lock_bh(&arena->lock);
+	for (i = 0; len <= RTW89_H2C_ARENA_BUF_LEN &&
+		    i < RTW89_H2C_ARENA_NUM; i++) {
+		idx = (arena->next + i) % RTW89_H2C_ARENA_NUM;
+		if (!arena->bufs[idx] || skb_shared(arena->bufs[idx]))
+			continue;
+
+		skb = skb_get(arena->bufs[idx]);
+		arena->next = (idx + 1) % RTW89_H2C_ARENA_NUM;
+		break;
+	}
+	if (skb)
+		arena->hit++;
+	else
+		arena->miss++;
+	spin_unlock_bh(&arena->lock);
+
+	if (!skb)
+		return rtw89_fw_h2c_alloc_skb_with_hdr(len);
+
+	/* drop the H2C header and TX descriptor of the previous command */
+	skb_trim(skb, 0);
+	skb_reserve(skb, arena->headroom - skb_headroom(skb));
+	memset(skb->data, 0, len);
+
+	return skb;
+}
+
 static u8 _fw_get_rdy(struct rtw89_dev *rtwdev)
 {
 	u8 val = rtw89_read8(rtwdev, R_AX_WCPU_FW_CTRL);
@@ -45,6 +119,8 @@ static u8 _fw_get_rdy(struct rtw89_dev *rtwdev)
 }
 
 #define FWDL_WAIT_CNT 400000
+#define FWDL_KICK_BATCH 8
+#define FWDL_CREDIT_TIMEOUT_US 100000
 int rtw89_fw_check_rdy(struct rtw89_dev *rtwdev)
 {
 	u8 val;
@@ -219,6 +295,171 @@ int rtw89_fw_recognize(struct rtw89_dev *rtwdev)
 	return 0;
 }
 
+void rtw89_fw_h2c_ack_init(struct rtw89_dev *rtwdev)
+{
+	struct rtw89_h2c_ack_info *ack = &rtwdev->fw.h2c_ack;
+
+	spin_lock_init(&ack->lock);
+	init_waitqueue_head(&ack->wq);
+}
+
+/* Called when the H2C sequence restarts after firmware download. Acks for
+ * commands sent to the previous firmware will never come.
+ */
+void rtw89_fw_h2c_ack_reset(struct rtw89_dev *rtwdev)
+{
+	struct rtw89_h2c_ack_info *ack = &rtwdev->fw.h2c_ack;
+	int i;
+
+	spin_lock_bh(&ack->lock);
+	for (i = 0; i < ARRAY_SIZE(ack->ent); i++)
+		ack->ent[i].wait = 0;
+	ack->outstanding = 0;
+	spin_unlock_bh(&ack->lock);
+
+	wake_up_all(&ack->wq);
+}
+
+static void rtw89_fw_h2c_ack_track(struct rtw89_dev *rtwdev, u8 seq,
+				   bool rack, bool dack)
+{
+	struct rtw89_h2c_ack_info *ack = &rtwdev->fw.h2c_ack;
+	struct rtw89_h2c_ack_ent *ent = &ack->ent[seq];
+	u8 wait = 0;
+
+	if (rack)
+		wait |= BIT(RTW89_H2C_ACK_REC);
+	if (dack)
+		wait |= BIT(RTW89_H2C_ACK_DONE);
+
+	spin_lock_bh(&ack->lock);
+	/* sequence wrapped before firmware acked the previous user */
+	if (ent->wait) {
+		ack->lost++;
+		ack->outstanding--;
+	}
+	ent->submit = ktime_get();
+	ent->wait = wait;
+	ent->ret = 0;
+	if (wait)
+		ack->outstanding++;
+	spin_unlock_bh(&ack->lock);
+}
+
+static void rtw89_fw_h2c_ack_hist(struct rtw89_h2c_ack_info *ack,
+				  enum rtw89_h2c_ack_type type, u32 lat_us)
+{
+	enum rtw89_h2c_ack_lat idx;
+
+	if (lat_us < 100)
+		idx = RTW89_H2C_ACK_LAT_100US;
+	else if (lat_us < 500)
+		idx = RTW89_H2C_ACK_LAT_500US;
+	else if (lat_us < 1000)
+		idx = RTW89_H2C_ACK_LAT_1MS;
+	else if (lat_us < 5000)
+		idx = RTW89_H2C_ACK_LAT_5MS;
+	else if (lat_us < 20000)
+		idx = RTW89_H2C_ACK_LAT_20MS;
+	else
+		idx = RTW89_H2C_ACK_LAT_SLOW;
+
+	ack->hist[type][idx]++;
+	if (lat_us > ack->lat_max_us[type])
+		ack->lat_max_us[type] = lat_us;
+}
+
+static void rtw89_fw_h2c_ack_complete(struct rtw89_dev *rtwdev, u8 seq,
+				      enum rtw89_h2c_ack_type type, u8 h2c_ret)
+{
+	struct rtw89_h2c_ack_info *ack = &rtwdev->fw.h2c_ack;
+	struct rtw89_h2c_ack_ent *ent = &ack->ent[seq];
+	u32 lat_us;
+
+	spin_lock(&ack->lock);
+	if (!(ent->wait & BIT(type))) {
+		spin_unlock(&ack->lock);
+		return;
+	}
+
+	lat_us = ktime_us_delta(ktime_get(), ent->submit);
+	rtw89_fw_h2c_ack_hist(ack, type, lat_us);
+
+	if (type == RTW89_H2C_ACK_DONE) {
+		/* firmware may skip the receive ack once it has done the job */
+		ent->wait = 0;
+		ent->ret = h2c_ret;
+	} else {
+		ent->wait &= ~BIT(type);
+	}
+	if (!ent->wait)
+		ack->outstanding--;
+	spin_unlock(&ack->lock);
+
+	wake_up_all(&ack->wq);
+}
+
+static bool rtw89_fw_h2c_ack_done(struct rtw89_h2c_ack_info *ack, u8 seq,
+				  enum rtw89_h2c_ack_type type, u8 *h2c_ret)
+{
+	struct rtw89_h2c_ack_ent *ent = &ack->ent[seq];
+	bool done;
+
+	spin_lock_bh(&ack->lock);
+	done = !(ent->wait & BIT(type));
+	if (done && h2c_ret)
+		*h2c_ret = ent->ret;
+	spin_unlock_bh(&ack->lock);
+
+	return done;
+}
+
+/* Wait for firmware to ack the H2C sent with sequence number @seq. The H2C
+ * must have been built with the matching rack/dack bit set, otherwise this
+ * returns immediately. Acks are matched in NAPI context, so the caller may
+ * hold rtwdev->mutex.
+ */
+int rtw89_fw_h2c_wait_ack(struct rtw89_dev *rtwdev, u8 seq,
+			  enum rtw89_h2c_ack_type type, unsigned int timeout_ms,
+			  u8 *h2c_ret)
+{
+	struct rtw89_h2c_ack_info *ack = &rtwdev->fw.h2c_ack;
+	unsigned long end = jiffies + msecs_to_jiffies(timeout_ms);
+	bool pending;
+	long left;
+
+	might_sleep();
+
+	rtw89_fw_h2c_batch_flush(rtwdev);
+
+	/* The H2C may still wait for CH12 credit. The queue work needs the
+	 * mutex the caller may hold, so drain the queue from here instead,
+	 * once per retry period for as long as anything is left in it.
+	 */
+	do {
+		pending = rtw89_core_h2c_txq_flush(rtwdev);
+		left = max_t(long, (long)(end - jiffies), 0);
+		if (pending)
+			left = min_t(long, left, RTW89_H2C_TXQ_RETRY_PERIOD);
+		left = wait_event_timeout(ack->wq,
+					  rtw89_fw_h2c_ack_done(ack, seq, type,
+								h2c_ret),
+					  left);
+	} while (!left && time_before(jiffies, end));
+
+	if (!left) {
+		spin_lock_bh(&ack->lock);
+		ack->timeout++;
+		spin_unlock_bh(&ack->lock);
+		rtw89_debug(rtwdev, RTW89_DBG_FW,
+			    "wait h2c seq %d %s ack timeout\n", seq,
+			    type == RTW89_H2C_ACK_DONE ? "done" : "rec");
+		return -ETIMEDOUT;
+	}
+
+	return 0;
+}
+
 void rtw89_h2c_pkt_set_hdr(struct rtw89_dev *rtwdev, struct sk_buff *skb,
 			   u8 type, u8 cat, u8 class, u8 func,
 			   bool rack, bool dack, u32 len)
@@ -229,6 +470,7 @@ void rtw89_h2c_pkt_set_hdr(struct rtw89_dev *rtwdev, struct sk_buff *skb,
 
 	if (!(rtwdev->fw.h2c_seq % 4))
 		rack = true;
+	rtw89_fw_h2c_ack_track(rtwdev, rtwdev->fw.h2c_seq, rack, dack);
 	hdr->hdr0 = cpu_to_le32(FIELD_PREP(H2C_HDR_DEL_TYPE, type) |
 				FIELD_PREP(H2C_HDR_CAT, cat) |
 				FIELD_PREP(H2C_HDR_CLASS, class) |
@@ -318,12 +560,65 @@ static int rtw89_fw_download_hdr(struct rtw89_dev *rtwdev, const u8 *fw, u32 len
 	return 0;
 }
 
+static int rtw89_fw_dl_get_credit(struct rtw89_dev *rtwdev, u32 *unkicked)
+{
+	u32 cnt;
+	int ret;
+
+	if (rtw89_hci_check_and_reclaim_tx_resource(rtwdev, RTW89_TXCH_CH12))
+		return 0;
+
+	/* CH12 is full; let firmware fetch what is waiting and wait for it */
+	if (*unkicked) {
+		rtw89_hci_tx_kick_off(rtwdev, RTW89_TXCH_CH12);
+		*unkicked = 0;
+	}
+
+	rtwdev->fw.dl_stats.credit_wait_cnt++;
+
+	ret = read_poll_timeout_atomic(rtw89_hci_check_and_reclaim_tx_resource,
+				       cnt, cnt, 1, FWDL_CREDIT_TIMEOUT_US,
+				       false, rtwdev, RTW89_TXCH_CH12);
+	if (ret)
+		rtw89_err(rtwdev, "no tx fwcmd resource for fw dl\n");
+
+	return ret;
+}
+
+static struct sk_buff *rtw89_fw_dl_get_chunk(struct rtw89_dev *rtwdev,
+					     struct sk_buff *cached,
+					     const u8 *data, u32 pkt_len)
+{
+	struct rtw89_fw_dl_stats *dl_stats = &rtwdev->fw.dl_stats;
+	struct sk_buff *skb;
+
+	/* The cached copy can be sent again once the HCI has dropped its
+	 * reference; only the TX descriptor pushed in front of it is stale.
+	 */
+	if (cached && !skb_shared(cached)) {
+		skb_pull(cached, cached->len - pkt_len);
+		dl_stats->chunk_reused++;
+		return skb_get(cached);
+	}
+
+	skb = rtw89_fw_h2c_alloc_skb_no_hdr(pkt_len);
+	if (!skb)
+		return NULL;
+	skb_put_data(skb, data, pkt_len);
+	dl_stats->chunk_copied++;
+
+	return skb;
+}
+
 static int __rtw89_fw_download_main(struct rtw89_dev *rtwdev,
-				    struct rtw89_fw_hdr_section_info *info)
+				    struct rtw89_fw_hdr_section_info *info,
+				    struct sk_buff **chunks,
+				    struct rtw89_fw_dl_section_stats *stats)
 {
 	struct sk_buff *skb;
 	const u8 *section = info->addr;
 	u32 residue_len = info->len;
+	u32 unkicked = 0;
 	u32 pkt_len;
 	int ret;
 
@@ -333,48 +628,84 @@ static int __rtw89_fw_download_main(struct rtw89_dev *rtwdev,
 		else
 			pkt_len = residue_len;
 
-		skb = rtw89_fw_h2c_alloc_skb_no_hdr(pkt_len);
+		skb = rtw89_fw_dl_get_chunk(rtwdev, chunks ? *chunks++ : NULL,
+					    section, pkt_len);
 		if (!skb) {
 			rtw89_err(rtwdev, "failed to alloc skb for fw dl\n");
-			return -ENOMEM;
+			ret = -ENOMEM;
+			goto out;
 		}
-		skb_put_data(skb, section, pkt_len);
 
-		ret = rtw89_h2c_tx(rtwdev, skb, true);
+		ret = rtw89_fw_dl_get_credit(rtwdev, &unkicked);
+		if (ret)
+			goto fail;
+
+		ret = rtw89_h2c_tx_fwdl(rtwdev, skb);
 		if (ret) {
 			rtw89_err(rtwdev, "failed to send h2c\n");
 			ret = -1;
 			goto fail;
 		}
 
+		stats->pkt_cnt++;
+		if (++unkicked >= FWDL_KICK_BATCH) {
+			rtw89_hci_tx_kick_off(rtwdev, RTW89_TXCH_CH12);
+			stats->kick_cnt++;
+			unkicked = 0;
+		}
+
 		section += pkt_len;
 		residue_len -= pkt_len;
 	}
 
-	return 0;
-fail:
-	dev_kfree_skb_any(skb);
+	ret = 0;
+out:
+	/* chunks already written must reach firmware even on error */
+	if (unkicked) {
+		rtw89_hci_tx_kick_off(rtwdev, RTW89_TXCH_CH12);
+		stats->kick_cnt++;
+	}
 
 	return ret;
+fail:
+	dev_kfree_skb_any(skb);
+	goto out;
 }
 
 static int rtw89_fw_download_main(struct rtw89_dev *rtwdev, const u8 *fw,
-				  struct rtw89_fw_bin_info *info)
+				  struct rtw89_fw_bin_info *info,
+				  struct rtw89_fw_dl_cache *cache)
 {
 	struct rtw89_fw_hdr_section_info *section_info = info->section_info;
+	struct rtw89_fw_dl_stats *dl_stats = &rtwdev->fw.dl_stats;
+	struct rtw89_fw_dl_section_stats *stats = dl_stats->section;
+	struct sk_buff **chunks = cache ? cache->chunks : NULL;
 	u8 section_num = info->section_num;
+	ktime_t start;
 	int ret;
 
+	dl_stats->section_num = section_num;
+
 	while (section_num--) {
-		ret = __rtw89_fw_download_main(rtwdev, section_info);
+		memset(stats, 0, sizeof(*stats));
+		stats->len = section_info->len;
+		start = ktime_get();
+		ret = __rtw89_fw_download_main(rtwdev, section_info, chunks,
+					       stats);
+		stats->time_us = ktime_us_delta(ktime_get(), start);
 		if (ret)
 			return ret;
+		if (chunks)
+			chunks += DIV_ROUND_UP(section_info->len,
+					       FWDL_SECTION_PER_PKT_LEN);
 		section_info++;
+		stats++;
 	}
 
-	mdelay(5);
-
+	/* poll for readiness right away instead of a fixed settle delay */
+	start = ktime_get();
 	ret = rtw89_fw_check_rdy(rtwdev);
+	dl_stats->rdy_us = ktime_us_delta(ktime_get(), start);
 	if (ret) {
 		rtw89_warn(rtwdev, "download firmware fail\n");
 		return ret;
@@ -414,13 +745,93 @@ static void rtw89_fw_dl_fail_dump(struct rtw89_dev *rtwdev)
 	rtw89_fw_prog_cnt_dump(rtwdev);
 }
 
+static void rtw89_fw_dl_cache_free(struct rtw89_fw_suit *fw_suit)
+{
+	struct rtw89_fw_dl_cache *cache = fw_suit->dl_cache;
+	u32 i;
+
+	if (!cache)
+		return;
+
+	for (i = 0; i < cache->chunk_num; i++)
+		dev_kfree_skb_any(cache->chunks[i]);
+	kfree(cache);
+	fw_suit->dl_cache = NULL;
+}
+
+/* Parse the image and copy it into download chunks once, so that downloads
+ * after SER, resume or restart neither parse nor allocate and copy again.
+ */
+static int rtw89_fw_dl_cache_build(struct rtw89_dev *rtwdev,
+				   struct rtw89_fw_suit *fw_suit)
+{
+	struct rtw89_fw_hdr_section_info *section_info;
+	struct rtw89_fw_dl_cache *cache;
+	struct sk_buff *skb;
+	u32 chunk_num = 0;
+	u32 residue_len;
+	const u8 *data;
+	u32 pkt_len;
+	int ret;
+	u8 i;
+
+	cache = kzalloc(sizeof(*cache), GFP_KERNEL);
+	if (!cache)
+		return -ENOMEM;
+
+	ret = rtw89_fw_hdr_parser(rtwdev, fw_suit->data, fw_suit->size,
+				  &cache->info);
+	if (ret) {
+		kfree(cache);
+		return ret;
+	}
+
+	for (i = 0; i < cache->info.section_num; i++)
+		chunk_num += DIV_ROUND_UP(cache->info.section_info[i].len,
+					  FWDL_SECTION_PER_PKT_LEN);
+
+	fw_suit->dl_cache = krealloc(cache, struct_size(cache, chunks, chunk_num),
+				     GFP_KERNEL);
+	if (!fw_suit->dl_cache) {
+		kfree(cache);
+		return -ENOMEM;
+	}
+	cache = fw_suit->dl_cache;
+
+	for (i = 0; i < cache->info.section_num; i++) {
+		section_info = &cache->info.section_info[i];
+		data = section_info->addr;
+		residue_len = section_info->len;
+
+		while (residue_len) {
+			pkt_len = min_t(u32, residue_len, FWDL_SECTION_PER_PKT_LEN);
+			skb = rtw89_fw_h2c_alloc_skb_no_hdr(pkt_len);
+			if (!skb) {
+				rtw89_fw_dl_cache_free(fw_suit);
+				return -ENOMEM;
+			}
+			skb_put_data(skb, data, pkt_len);
+			cache->chunks[cache->chunk_num++] = skb;
+
+			data += pkt_len;
+			residue_len -= pkt_len;
+		}
+	}
+
+	return 0;
+}
+
 int rtw89_fw_download(struct rtw89_dev *rtwdev, enum rtw89_fw_type type)
 {
 	struct rtw89_fw_info *fw_info = &rtwdev->fw;
 	struct rtw89_fw_suit *fw_suit = rtw89_fw_suit_get(rtwdev, type);
-	struct rtw89_fw_bin_info info;
+	struct rtw89_fw_dl_stats *dl_stats = &fw_info->dl_stats;
+	struct rtw89_fw_dl_cache *cache;
+	struct rtw89_fw_bin_info *info;
+	struct rtw89_fw_bin_info parsed;
 	const u8 *fw = fw_suit->data;
 	u32 len = fw_suit->size;
+	ktime_t start, hdr_start;
 	u8 val;
 	int ret;
 
@@ -429,10 +840,29 @@ int rtw89_fw_download(struct rtw89_dev *rtwdev, enum rtw89_fw_type type)
 		return -ENOENT;
 	}
 
-	ret = rtw89_fw_hdr_parser(rtwdev, fw, len, &info);
-	if (ret) {
-		rtw89_err(rtwdev, "parse fw header fail\n");
-		goto fwdl_err;
+	/* H2Cs still waiting for credit were meant for the old firmware */
+	rtw89_core_h2c_txq_purge(rtwdev);
+
+	start = ktime_get();
+	dl_stats->dl_cnt++;
+	dl_stats->credit_wait_cnt = 0;
+
+	dl_stats->chunk_reused = 0;
+	dl_stats->chunk_copied = 0;
+
+	if (!fw_suit->dl_cache && rtw89_fw_dl_cache_build(rtwdev, fw_suit))
+		rtw89_debug(rtwdev, RTW89_DBG_FW, "fw download cache unavailable\n");
+
+	cache = fw_suit->dl_cache;
+	if (cache) {
+		info = &cache->info;
+	} else {
+		ret = rtw89_fw_hdr_parser(rtwdev, fw, len, &parsed);
+		if (ret) {
+			rtw89_err(rtwdev, "parse fw header fail\n");
+			goto fwdl_err;
+		}
+		info = &parsed;
 	}
 
 	ret = read_poll_timeout_atomic(rtw89_read8, val, val & B_AX_H2C_PATH_RDY,
@@ -443,13 +873,15 @@ int rtw89_fw_download(struct rtw89_dev *rtwdev, enum rtw89_fw_type type)
 		goto fwdl_err;
 	}
 
-	ret = rtw89_fw_download_hdr(rtwdev, fw, info.hdr_len);
+	hdr_start = ktime_get();
+	ret = rtw89_fw_download_hdr(rtwdev, fw, info->hdr_len);
+	dl_stats->hdr_us = ktime_us_delta(ktime_get(), hdr_start);
 	if (ret) {
 		ret = -EBUSY;
 		goto fwdl_err;
 	}
 
-	ret = rtw89_fw_download_main(rtwdev, fw, &info);
+	ret = rtw89_fw_download_main(rtwdev, fw, info, cache);
 	if (ret) {
 		ret = -EBUSY;
 		goto fwdl_err;
@@ -457,9 +889,15 @@ int rtw89_fw_download(struct rtw89_dev *rtwdev, enum rtw89_fw_type type)
 
 	fw_info->h2c_seq = 0;
 	fw_info->rec_seq = 0;
+	fw_info->h2c_batch.pending = 0;
+	rtw89_fw_h2c_ack_reset(rtwdev);
 	rtwdev->mac.rpwm_seq_num = RPWM_SEQ_NUM_MAX;
 	rtwdev->mac.cpwm_seq_num = CPWM_SEQ_NUM_MAX;
 
+	dl_stats->total_us = ktime_us_delta(ktime_get(), start);
+	rtw89_debug(rtwdev, RTW89_DBG_FW, "fw download done in %u us\n",
+		    dl_stats->total_us);
+
 	return ret;
 
 fwdl_err:
@@ -518,6 +956,9 @@ void rtw89_unload_firmware(struct rtw89_dev *rtwdev)
 
 	rtw89_wait_firmware_completion(rtwdev);
 
+	rtw89_fw_dl_cache_free(&fw->normal);
+	rtw89_fw_dl_cache_free(&fw->wowlan);
+
 	if (fw->firmware)
 		release_firmware(fw->firmware);
 }
@@ -696,7 +1137,7 @@ int rtw89_fw_h2c_lps_parm(struct rtw89_dev *rtwdev,
 {
 	struct sk_buff *skb;
 
-	skb = rtw89_fw_h2c_alloc_skb_with_hdr(H2C_LPS_PARM_LEN);
+	skb = rtw89_fw_h2c_arena_alloc(rtwdev, H2C_LPS_PARM_LEN);
 	if (!skb) {
 		rtw89_err(rtwdev, "failed to alloc skb for fw dl\n");
 		return -ENOMEM;
@@ -942,22 +1383,76 @@ fail:
 }
 
 #define H2C_BCN_BASE_LEN 12
+void rtw89_fw_bcn_cache_invalidate(struct rtw89_vif *rtwvif)
+{
+	struct rtw89_bcn_cache *cache = &rtwvif->bcn_cache;
+
+	dev_kfree_skb_any(cache->skb);
+	cache->skb = NULL;
+}
+
+/* Firmware keeps its own DTIM count, so a beacon that differs from the last
+ * template only in the DTIM count of the TIM element need not be sent.
+ */
+static bool rtw89_fw_bcn_cache_match(struct rtw89_bcn_cache *cache,
+				     const u8 *hdr, struct sk_buff *bcn,
+				     u16 tim_offset)
+{
+	const u8 *old;
+	u32 dtim_cnt = tim_offset + 2;
+
+	if (!cache->skb || cache->skb->len != bcn->len ||
+	    memcmp(cache->hdr, hdr, H2C_BCN_BASE_LEN))
+		return false;
+
+	old = cache->skb->data;
+	if (dtim_cnt >= bcn->len)
+		return !memcmp(old, bcn->data, bcn->len);
+
+	return !memcmp(old, bcn->data, dtim_cnt) &&
+	       !memcmp(old + dtim_cnt + 1, bcn->data + dtim_cnt + 1,
+		       bcn->len - dtim_cnt - 1);
+}
+
 int rtw89_fw_h2c_update_beacon(struct rtw89_dev *rtwdev,
 			       struct rtw89_vif *rtwvif)
 {
+	struct rtw89_bcn_cache *cache = &rtwvif->bcn_cache;
 	struct rtw89_hal *hal = &rtwdev->hal;
 	struct ieee80211_vif *vif = rtwvif_to_vif(rtwvif);
+	u8 hdr[H2C_BCN_BASE_LEN] __aligned(4) = {0};
 	struct sk_buff *skb;
 	struct sk_buff *skb_beacon;
 	u16 tim_offset;
 	int bcn_total_len;
 
+	BUILD_BUG_ON(sizeof(cache->hdr) != H2C_BCN_BASE_LEN);
+
 	skb_beacon = ieee80211_beacon_get_tim(rtwdev->hw, vif, &tim_offset, NULL);
 	if (!skb_beacon) {
 		rtw89_err(rtwdev, "failed to get beacon skb\n");
 		return -ENOMEM;
 	}
 
+	SET_BCN_UPD_PORT(hdr, rtwvif->port);
+	SET_BCN_UPD_MBSSID(hdr, 0);
+	SET_BCN_UPD_BAND(hdr, rtwvif->mac_idx);
+	SET_BCN_UPD_GRP_IE_OFST(hdr, tim_offset);
+	SET_BCN_UPD_MACID(hdr, rtwvif->mac_id);
+	SET_BCN_UPD_SSN_SEL(hdr, RTW89_MGMT_HW_SSN_SEL);
+	SET_BCN_UPD_SSN_MODE(hdr, RTW89_MGMT_HW_SEQ_MODE);
+	SET_BCN_UPD_RATE(hdr, hal->current_band_type == RTW89_BAND_2G ?
+			      RTW89_HW_RATE_CCK1 : RTW89_HW_RATE_OFDM6);
+
+	if (rtw89_fw_bcn_cache_match(cache, hdr, skb_beacon, tim_offset)) {
+		dev_kfree_skb_any(skb_beacon);
+		cache->skip_cnt++;
+		rtw89_debug(rtwdev, RTW89_DBG_FW,
+			    "port %d beacon unchanged, skip update\n",
+			    rtwvif->port);
+		return 0;
+	}
+
 	bcn_total_len = H2C_BCN_BASE_LEN + skb_beacon->len;
 	skb = rtw89_fw_h2c_alloc_skb_with_hdr(bcn_total_len);
 	if (!skb) {
@@ -965,20 +1460,8 @@ int rtw89_fw_h2c_update_beacon(struct rtw89_dev *rtwdev,
 		dev_kfree_skb_any(skb_beacon);
 		return -ENOMEM;
 	}
-	skb_put(skb, H2C_BCN_BASE_LEN);
-
-	SET_BCN_UPD_PORT(skb->data, rtwvif->port);
-	SET_BCN_UPD_MBSSID(skb->data, 0);
-	SET_BCN_UPD_BAND(skb->data, rtwvif->mac_idx);
-	SET_BCN_UPD_GRP_IE_OFST(skb->data, tim_offset);
-	SET_BCN_UPD_MACID(skb->data, rtwvif->mac_id);
-	SET_BCN_UPD_SSN_SEL(skb->data, RTW89_MGMT_HW_SSN_SEL);
-	SET_BCN_UPD_SSN_MODE(skb->data, RTW89_MGMT_HW_SEQ_MODE);
-	SET_BCN_UPD_RATE(skb->data, hal->current_band_type == RTW89_BAND_2G ?
-				    RTW89_HW_RATE_CCK1 : RTW89_HW_RATE_OFDM6);
-
+	skb_put_data(skb, hdr, H2C_BCN_BASE_LEN);
 	skb_put_data(skb, skb_beacon->data, skb_beacon->len);
-	dev_kfree_skb_any(skb_beacon);
 
 	rtw89_h2c_pkt_set_hdr(rtwdev, skb, FWCMD_TYPE_H2C,
 			      H2C_CAT_MAC, H2C_CL_MAC_FR_EXCHG,
@@ -988,9 +1471,17 @@ int rtw89_fw_h2c_update_beacon(struct rtw89_dev *rtwdev,
 	if (rtw89_h2c_tx(rtwdev, skb, false)) {
 		rtw89_err(rtwdev, "failed to send h2c\n");
 		dev_kfree_skb_any(skb);
+		dev_kfree_skb_any(skb_beacon);
 		return -EBUSY;
 	}
 
+	/* keep the beacon from mac80211 as the template to compare against */
+	dev_kfree_skb_any(cache->skb);
+	cache->skb = skb_beacon;
+	memcpy(cache->hdr, hdr, H2C_BCN_BASE_LEN);
+	cache->last_upd = jiffies;
+	cache->upd_cnt++;
+
 	return 0;
 }
 
@@ -1189,7 +1680,7 @@ int rtw89_fw_h2c_ra(struct rtw89_dev *rtwdev, struct rtw89_ra_info *ra, bool csi
 	struct sk_buff *skb;
 	u8 *cmd;
 
-	skb = rtw89_fw_h2c_alloc_skb_with_hdr(H2C_RA_LEN);
+	skb = rtw89_fw_h2c_arena_alloc(rtwdev, H2C_RA_LEN);
 	if (!skb) {
 		rtw89_err(rtwdev, "failed to alloc skb for h2c join\n");
 		return -ENOMEM;
@@ -1260,7 +1751,7 @@ int rtw89_fw_h2c_cxdrv_init(struct rtw89_dev *rtwdev)
 	struct sk_buff *skb;
 	u8 *cmd;
 
-	skb = rtw89_fw_h2c_alloc_skb_with_hdr(H2C_LEN_CXDRVINFO_INIT);
+	skb = rtw89_fw_h2c_arena_alloc(rtwdev, H2C_LEN_CXDRVINFO_INIT);
 	if (!skb) {
 		rtw89_err(rtwdev, "failed to alloc skb for h2c cxdrv_init\n");
 		return -ENOMEM;
@@ -1319,7 +1810,7 @@ int rtw89_fw_h2c_cxdrv_role(struct rtw89_dev *rtwdev)
 	u8 *cmd;
 	int i;
 
-	skb = rtw89_fw_h2c_alloc_skb_with_hdr(H2C_LEN_CXDRVINFO_ROLE);
+	skb = rtw89_fw_h2c_arena_alloc(rtwdev, H2C_LEN_CXDRVINFO_ROLE);
 	if (!skb) {
 		rtw89_err(rtwdev, "failed to alloc skb for h2c cxdrv_role\n");
 		return -ENOMEM;
@@ -1387,7 +1878,7 @@ int rtw89_fw_h2c_cxdrv_ctrl(struct rtw89_dev *rtwdev)
 	struct sk_buff *skb;
 	u8 *cmd;
 
-	skb = rtw89_fw_h2c_alloc_skb_with_hdr(H2C_LEN_CXDRVINFO_CTRL);
+	skb = rtw89_fw_h2c_arena_alloc(rtwdev, H2C_LEN_CXDRVINFO_CTRL);
 	if (!skb) {
 		rtw89_err(rtwdev, "failed to alloc skb for h2c cxdrv_ctrl\n");
 		return -ENOMEM;
@@ -1429,7 +1920,7 @@ int rtw89_fw_h2c_cxdrv_rfk(struct rtw89_dev *rtwdev)
 	struct sk_buff *skb;
 	u8 *cmd;
 
-	skb = rtw89_fw_h2c_alloc_skb_with_hdr(H2C_LEN_CXDRVINFO_RFK);
+	skb = rtw89_fw_h2c_arena_alloc(rtwdev, H2C_LEN_CXDRVINFO_RFK);
 	if (!skb) {
 		rtw89_err(rtwdev, "failed to alloc skb for h2c cxdrv_ctrl\n");
 		return -ENOMEM;
@@ -1494,33 +1985,38 @@ fail:
 	return -EBUSY;
 }
 
+int rtw89_fw_h2c_raw_skb_with_hdr(struct rtw89_dev *rtwdev,
+				  struct sk_buff *skb, u8 h2c_class,
+				  u8 h2c_func, bool rack, bool dack)
+{
+	rtw89_h2c_pkt_set_hdr(rtwdev, skb, FWCMD_TYPE_H2C,
+			      H2C_CAT_OUTSRC, h2c_class, h2c_func, rack, dack,
+			      skb->len);
+
+	if (rtw89_h2c_tx(rtwdev, skb, false)) {
+		rtw89_err(rtwdev, "failed to send h2c\n");
+		dev_kfree_skb_any(skb);
+		return -EBUSY;
+	}
+
+	return 0;
+}
+
 int rtw89_fw_h2c_raw_with_hdr(struct rtw89_dev *rtwdev,
 			      u8 h2c_class, u8 h2c_func, u8 *buf, u16 len,
 			      bool rack, bool dack)
 {
 	struct sk_buff *skb;
 
-	skb = rtw89_fw_h2c_alloc_skb_with_hdr(len);
+	skb = rtw89_fw_h2c_arena_alloc(rtwdev, len);
 	if (!skb) {
 		rtw89_err(rtwdev, "failed to alloc skb for raw with hdr\n");
 		return -ENOMEM;
 	}
 	skb_put_data(skb, buf, len);
 
-	rtw89_h2c_pkt_set_hdr(rtwdev, skb, FWCMD_TYPE_H2C,
-			      H2C_CAT_OUTSRC, h2c_class, h2c_func, rack, dack,
-			      len);
-
-	if (rtw89_h2c_tx(rtwdev, skb, false)) {
-		rtw89_err(rtwdev, "failed to send h2c\n");
-		goto fail;
-	}
-
-	return 0;
-fail:
-	dev_kfree_skb_any(skb);
-
-	return -EBUSY;
+	return rtw89_fw_h2c_raw_skb_with_hdr(rtwdev, skb, h2c_class, h2c_func,
+					     rack, dack);
 }
 
 int rtw89_fw_h2c_raw(struct rtw89_dev *rtwdev, const u8 *buf, u16 len)
@@ -1570,8 +2066,79 @@ void rtw89_fw_free_all_early_h2c(struct rtw89_dev *rtwdev)
 	mutex_unlock(&rtwdev->mutex);
 }
 
+/* A burst of H2Cs issued between rtw89_fw_h2c_batch_begin() and
+ * rtw89_fw_h2c_batch_end() shares a single CH12 doorbell. Each H2C still
+ * occupies its own TXBD since a FWCMD WD carries one command only, but the
+ * firmware gets to fetch the whole burst at once instead of being kicked
+ * once per command. Batches may nest; the doorbell is rung when the
+ * outermost batch ends, or earlier via rtw89_fw_h2c_batch_flush() if the
+ * caller is about to wait for firmware to act on what was sent.
+ */
+void rtw89_fw_h2c_batch_begin(struct rtw89_dev *rtwdev)
+{
+	lockdep_assert_held(&rtwdev->mutex);
+
+	rtwdev->fw.h2c_batch.depth++;
+}
+
+void rtw89_fw_h2c_batch_flush(struct rtw89_dev *rtwdev)
+{
+	struct rtw89_h2c_batch *batch = &rtwdev->fw.h2c_batch;
+
+	if (!batch->pending)
+		return;
+
+	batch->pending = 0;
+	rtw89_hci_tx_kick_off(rtwdev, RTW89_TXCH_CH12);
+}
+
+void rtw89_fw_h2c_batch_end(struct rtw89_dev *rtwdev)
+{
+	struct rtw89_h2c_batch *batch = &rtwdev->fw.h2c_batch;
+
+	lockdep_assert_held(&rtwdev->mutex);
+
+	if (WARN_ON(!batch->depth))
+		return;
+
+	if (--batch->depth)
+		return;
+
+	rtw89_fw_h2c_batch_flush(rtwdev);
+}
+
+static void rtw89_fw_c2h_ack_irqsafe(struct rtw89_dev *rtwdev,
+				     struct sk_buff *c2h)
+{
+	u8 category, class, func;
+
+	if (c2h->len < RTW89_C2H_HEADER_LEN + 4)
+		return;
+
+	category = RTW89_GET_C2H_CATEGORY(c2h->data);
+	class = RTW89_GET_C2H_CLASS(c2h->data);
+	func = RTW89_GET_C2H_FUNC(c2h->data);
+
+	if (category != RTW89_C2H_CAT_MAC || class != RTW89_MAC_C2H_CLASS_INFO)
+		return;
+
+	if (func == RTW89_MAC_C2H_FUNC_REC_ACK)
+		rtw89_fw_h2c_ack_complete(rtwdev,
+					  RTW89_GET_MAC_C2H_REV_ACK_H2C_SEQ(c2h->data),
+					  RTW89_H2C_ACK_REC, 0);
+	else if (func == RTW89_MAC_C2H_FUNC_DONE_ACK)
+		rtw89_fw_h2c_ack_complete(rtwdev,
+					  RTW89_GET_MAC_C2H_DONE_ACK_H2C_SEQ(c2h->data),
+					  RTW89_H2C_ACK_DONE,
+					  RTW89_GET_MAC_C2H_DONE_ACK_H2C_RETURN(c2h->data));
+}
+
 void rtw89_fw_c2h_irqsafe(struct rtw89_dev *rtwdev, struct sk_buff *c2h)
 {
+	/* match acks here rather than in c2h_work, which needs the mutex
+	 * a waiter in rtw89_fw_h2c_wait_ack() may be holding
+	 */
+	rtw89_fw_c2h_ack_irqsafe(rtwdev, c2h);
 	skb_queue_tail(&rtwdev->c2h_queue, c2h);
 	ieee80211_queue_work(rtwdev->hw, &rtwdev->c2h_work);
 }
@@ -1610,19 +2177,95 @@ static void rtw89_fw_c2h_cmd_handle(struct rtw89_dev *rtwdev,
 		rtw89_hex_dump(rtwdev, RTW89_DBG_FW, "C2H: ", skb->data, skb->len);
 }
 
+static bool rtw89_fw_c2h_chk_atomic(struct sk_buff *skb)
+{
+	u8 category = RTW89_GET_C2H_CATEGORY(skb->data);
+	u8 class = RTW89_GET_C2H_CLASS(skb->data);
+	u8 func = RTW89_GET_C2H_FUNC(skb->data);
+
+	switch (category) {
+	case RTW89_C2H_CAT_TEST:
+		return true;
+	case RTW89_C2H_CAT_MAC:
+		return rtw89_mac_c2h_chk_atomic(class, func);
+	case RTW89_C2H_CAT_OUTSRC:
+		if (class >= RTW89_PHY_C2H_CLASS_BTC_MIN &&
+		    class <= RTW89_PHY_C2H_CLASS_BTC_MAX)
+			return false;
+		return rtw89_phy_c2h_chk_atomic(class, func);
+	default:
+		return false;
+	}
+}
+
+static void rtw89_fw_c2h_handle_timed(struct rtw89_dev *rtwdev,
+				      struct sk_buff *skb)
+{
+	struct rtw89_c2h_stats *stats = &rtwdev->fw.c2h_stats;
+	struct rtw89_c2h_class_stats *cls;
+	u8 category = RTW89_GET_C2H_CATEGORY(skb->data);
+	u8 class = RTW89_GET_C2H_CLASS(skb->data);
+	ktime_t start = ktime_get();
+	u32 time_us;
+
+	rtw89_fw_c2h_cmd_handle(rtwdev, skb);
+
+	time_us = ktime_us_delta(ktime_get(), start);
+	cls = &stats->cls[category][class];
+	cls->cnt++;
+	cls->total_us += time_us;
+	if (time_us > cls->max_us)
+		cls->max_us = time_us;
+}
+
+/* Drain everything queued so far as one batch. C2Hs that only log, count or
+ * update RA state are handled without the mutex, the others are handled in
+ * arrival order under a single mutex hold.
+ */
 void rtw89_fw_c2h_work(struct work_struct *work)
 {
 	struct rtw89_dev *rtwdev = container_of(work, struct rtw89_dev,
 						c2h_work);
-	struct sk_buff *skb, *tmp;
+	struct rtw89_c2h_stats *stats = &rtwdev->fw.c2h_stats;
+	struct sk_buff_head batch, locked;
+	struct sk_buff *skb;
+	u32 cnt;
+
+	__skb_queue_head_init(&batch);
+	__skb_queue_head_init(&locked);
+
+	spin_lock_irq(&rtwdev->c2h_queue.lock);
+	skb_queue_splice_init(&rtwdev->c2h_queue, &batch);
+	spin_unlock_irq(&rtwdev->c2h_queue.lock);
+
+	cnt = skb_queue_len(&batch);
+	if (!cnt)
+		return;
 
-	skb_queue_walk_safe(&rtwdev->c2h_queue, skb, tmp) {
-		skb_unlink(skb, &rtwdev->c2h_queue);
-		mutex_lock(&rtwdev->mutex);
-		rtw89_fw_c2h_cmd_handle(rtwdev, skb);
-		mutex_unlock(&rtwdev->mutex);
+	stats->batch_cnt++;
+	stats->max_batch = max(stats->max_batch, cnt);
+
+	while ((skb = __skb_dequeue(&batch))) {
+		if (!rtw89_fw_c2h_chk_atomic(skb)) {
+			__skb_queue_tail(&locked, skb);
+			continue;
+		}
+
+		stats->atomic_cnt++;
+		rtw89_fw_c2h_handle_timed(rtwdev, skb);
+		dev_kfree_skb_any(skb);
+	}
+
+	if (skb_queue_empty(&locked))
+		return;
+
+	mutex_lock(&rtwdev->mutex);
+	while ((skb = __skb_dequeue(&locked))) {
+		stats->locked_cnt++;
+		rtw89_fw_c2h_handle_timed(rtwdev, skb);
 		dev_kfree_skb_any(skb);
 	}
+	mutex_unlock(&rtwdev->mutex);
 }
 
 static int rtw89_fw_write_h2c_reg(struct rtw89_dev *rtwdev,
@@ -1635,7 +2278,7 @@ static int rtw89_fw_write_h2c_reg(struct rtw89_dev *rtwdev,
 	u8 i, val, len;
 	int ret;
 
-	ret = read_poll_timeout(rtw89_read8, val, val == 0, 1000, 5000, false,
+	ret = read_poll_timeout(rtw89_read8, val, val == 0, 50, 5000, false,
 				rtwdev, R_AX_H2CREG_CTRL);
 	if (ret) {
 		rtw89_warn(rtwdev, "FW does not process h2c registers\n");
@@ -1687,10 +2330,42 @@ static int rtw89_fw_read_c2h_reg(struct rtw89_dev *rtwdev,
 	return 0;
 }
 
+void rtw89_fw_reg_mbox_init(struct rtw89_dev *rtwdev)
+{
+	init_completion(&rtwdev->fw.reg_mbox.c2h_done);
+}
+
+void rtw89_fw_c2h_reg_irqsafe(struct rtw89_dev *rtwdev)
+{
+	struct rtw89_fw_reg_mbox *mbox = &rtwdev->fw.reg_mbox;
+
+	complete(&mbox->c2h_done);
+}
+EXPORT_SYMBOL(rtw89_fw_c2h_reg_irqsafe);
+
+void rtw89_fw_c2h_reg_irq_ready(struct rtw89_dev *rtwdev, bool ready)
+{
+	WRITE_ONCE(rtwdev->fw.reg_mbox.irq_ready, ready);
+}
+EXPORT_SYMBOL(rtw89_fw_c2h_reg_irq_ready);
+
+static void rtw89_fw_reg_mbox_rtt(struct rtw89_fw_reg_mbox *mbox, ktime_t start)
+{
+	u32 rtt_us = ktime_us_delta(ktime_get(), start);
+
+	mbox->rtt_cnt++;
+	mbox->rtt_sum_us += rtt_us;
+	if (rtt_us > mbox->rtt_max_us)
+		mbox->rtt_max_us = rtt_us;
+}
+
 int rtw89_fw_msg_reg(struct rtw89_dev *rtwdev,
 		     struct rtw89_mac_h2c_info *h2c_info,
 		     struct rtw89_mac_c2h_info *c2h_info)
 {
+	struct rtw89_fw_reg_mbox *mbox = &rtwdev->fw.reg_mbox;
+	bool use_irq = false;
+	ktime_t start;
 	u32 ret;
 
 	if (h2c_info && h2c_info->id != RTW89_FWCMD_H2CREG_FUNC_GET_FEATURE)
@@ -1699,22 +2374,47 @@ int rtw89_fw_msg_reg(struct rtw89_dev *rtwdev,
 	if (!h2c_info && !c2h_info)
 		return -EINVAL;
 
+	start = ktime_get();
+
 	if (!h2c_info)
 		goto recv_c2h;
 
+	/* Writing H2C registers already sleeps, so a request/response pair
+	 * can sleep for the response too once interrupts are up.
+	 */
+	use_irq = c2h_info && READ_ONCE(mbox->irq_ready);
+	if (use_irq)
+		reinit_completion(&mbox->c2h_done);
+
 	ret = rtw89_fw_write_h2c_reg(rtwdev, h2c_info);
 	if (ret)
-		return ret;
+		goto fail;
 
 recv_c2h:
 	if (!c2h_info)
 		return 0;
 
+	if (use_irq &&
+	    wait_for_completion_timeout(&mbox->c2h_done,
+					msecs_to_jiffies(RTW89_C2H_REG_IRQ_TIMEOUT)))
+		mbox->irq_cnt++;
+	else
+		mbox->poll_cnt++;
+
+	/* returns at once if the interrupt has been seen; otherwise this is
+	 * the busy-poll fallback
+	 */
 	ret = rtw89_fw_read_c2h_reg(rtwdev, c2h_info);
 	if (ret)
-		return ret;
+		goto fail;
+
+	rtw89_fw_reg_mbox_rtt(mbox, start);
 
 	return 0;
+
+fail:
+	mbox->fail_cnt++;
+	return ret;
 }
 
 void rtw89_fw_st_dbg_dump(struct rtw89_dev *rtwdev)
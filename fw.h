@@ -33,6 +33,7 @@ enum rtw89_fw_dl_status {
 #define RTW89_C2HREG_HDR_LEN 2
 #define RTW89_H2CREG_HDR_LEN 2
 #define RTW89_C2H_TIMEOUT 1000000
+#define RTW89_C2H_REG_IRQ_TIMEOUT 20 /* ms */
 struct rtw89_mac_c2h_info {
 	u8 id;
 	u8 content_len;
@@ -123,7 +124,6 @@ enum rtw89_fw_log_comp {
 	RTW89_FW_LOG_COMP_MCC = 20,
 };
 
-#define FWDL_SECTION_MAX_NUM 10
 #define FWDL_SECTION_CHKSUM_LEN	8
 #define FWDL_SECTION_PER_PKT_LEN 2020
 
@@ -140,6 +140,15 @@ struct rtw89_fw_bin_info {
 	struct rtw89_fw_hdr_section_info section_info[FWDL_SECTION_MAX_NUM];
 };
 
+struct rtw89_fw_dl_cache {
+	struct rtw89_fw_bin_info info;
+	u32 chunk_num;
+	/* download chunks of all sections in order, each holding a reference
+	 * of its own so the HCI release doesn't free it
+	 */
+	struct sk_buff *chunks[];
+};
+
 struct rtw89_fw_macid_pause_grp {
 	__le32 pause_grp[4];
 	__le32 mask_grp[4];
@@ -1800,6 +1809,9 @@ struct rtw89_fw_h2c_rf_reg_info {
 #define H2C_SEC_CAM_LEN			24
 
 #define H2C_HEADER_LEN			8
+/* room for the H2C header and the TX descriptor pushed by the HCI */
+#define RTW89_H2C_ARENA_HEADROOM	(H2C_HEADER_LEN + 24)
+#define RTW89_H2C_ARENA_BUF_LEN		256
 #define H2C_HDR_CAT			GENMASK(1, 0)
 #define H2C_HDR_CLASS			GENMASK(7, 2)
 #define H2C_HDR_FUNC			GENMASK(15, 8)
@@ -1862,6 +1874,8 @@ struct rtw89_fw_h2c_rf_reg_info {
 #define H2C_CL_OUTSRC_RF_REG_A		0x8
 #define H2C_CL_OUTSRC_RF_REG_B		0x9
 
+#define RTW89_H2C_BATCH_MAX_PENDING	16
+
 int rtw89_fw_check_rdy(struct rtw89_dev *rtwdev);
 int rtw89_fw_recognize(struct rtw89_dev *rtwdev);
 int rtw89_fw_download(struct rtw89_dev *rtwdev, enum rtw89_fw_type type);
@@ -1878,6 +1892,7 @@ int rtw89_fw_h2c_assoc_cmac_tbl(struct rtw89_dev *rtwdev,
 				struct ieee80211_sta *sta);
 int rtw89_fw_h2c_txtime_cmac_tbl(struct rtw89_dev *rtwdev,
 				 struct rtw89_sta *rtwsta);
+void rtw89_fw_bcn_cache_invalidate(struct rtw89_vif *rtwvif);
 int rtw89_fw_h2c_update_beacon(struct rtw89_dev *rtwdev,
 			       struct rtw89_vif *rtwvif);
 int rtw89_fw_h2c_cam(struct rtw89_dev *rtwdev, struct rtw89_vif *vif,
@@ -1903,6 +1918,9 @@ int rtw89_fw_h2c_cxdrv_rfk(struct rtw89_dev *rtwdev);
 int rtw89_fw_h2c_rf_reg(struct rtw89_dev *rtwdev,
 			struct rtw89_fw_h2c_rf_reg_info *info,
 			u16 len, u8 page);
+int rtw89_fw_h2c_raw_skb_with_hdr(struct rtw89_dev *rtwdev,
+				  struct sk_buff *skb, u8 h2c_class,
+				  u8 h2c_func, bool rack, bool dack);
 int rtw89_fw_h2c_raw_with_hdr(struct rtw89_dev *rtwdev,
 			      u8 h2c_class, u8 h2c_func, u8 *buf, u16 len,
 			      bool rack, bool dack);
@@ -1917,10 +1935,49 @@ int rtw89_fw_h2c_lps_parm(struct rtw89_dev *rtwdev,
 			  struct rtw89_lps_parm *lps_param);
 struct sk_buff *rtw89_fw_h2c_alloc_skb_with_hdr(u32 len);
 struct sk_buff *rtw89_fw_h2c_alloc_skb_no_hdr(u32 len);
+int rtw89_fw_h2c_arena_init(struct rtw89_dev *rtwdev);
+void rtw89_fw_h2c_arena_deinit(struct rtw89_dev *rtwdev);
+struct sk_buff *rtw89_fw_h2c_arena_alloc(struct rtw89_dev *rtwdev, u32 len);
+void rtw89_fw_reg_mbox_init(struct rtw89_dev *rtwdev);
+void rtw89_fw_c2h_reg_irqsafe(struct rtw89_dev *rtwdev);
+void rtw89_fw_c2h_reg_irq_ready(struct rtw89_dev *rtwdev, bool ready);
 int rtw89_fw_msg_reg(struct rtw89_dev *rtwdev,
 		     struct rtw89_mac_h2c_info *h2c_info,
 		     struct rtw89_mac_c2h_info *c2h_info);
 int rtw89_fw_h2c_fw_log(struct rtw89_dev *rtwdev, bool enable);
 void rtw89_fw_st_dbg_dump(struct rtw89_dev *rtwdev);
+void rtw89_fw_h2c_batch_begin(struct rtw89_dev *rtwdev);
+void rtw89_fw_h2c_batch_end(struct rtw89_dev *rtwdev);
+void rtw89_fw_h2c_batch_flush(struct rtw89_dev *rtwdev);
+void rtw89_fw_h2c_ack_init(struct rtw89_dev *rtwdev);
+void rtw89_fw_h2c_ack_reset(struct rtw89_dev *rtwdev);
+int rtw89_fw_h2c_wait_ack(struct rtw89_dev *rtwdev, u8 seq,
+			  enum rtw89_h2c_ack_type type, unsigned int timeout_ms,
+			  u8 *h2c_ret);
+
+/* Sequence number the next H2C built by rtw89_h2c_pkt_set_hdr() will carry.
+ * Sample it before calling a builder to wait for that command's ack.
+ */
+static inline u8 rtw89_fw_h2c_next_seq(struct rtw89_dev *rtwdev)
+{
+	return rtwdev->fw.h2c_seq;
+}
+
+/* Called by rtw89_h2c_tx() after an H2C has been written to CH12. Returns
+ * true if the doorbell is to be deferred to the end of the current batch.
+ */
+static inline bool rtw89_fw_h2c_batch_defer_kick(struct rtw89_dev *rtwdev)
+{
+	struct rtw89_h2c_batch *batch = &rtwdev->fw.h2c_batch;
+
+	if (!batch->depth)
+		return false;
+
+	if (++batch->pending < RTW89_H2C_BATCH_MAX_PENDING)
+		return true;
+
+	batch->pending = 0;
+	return false;
+}
 
 #endif
@@ -0,0 +1,84 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0 OR BSD-3-Clause
+#
+# Decode the binary firmware log stream of rtw89.
+#
+# Records are read from the relay file the driver creates in its debugfs
+# directory, e.g. /sys/kernel/debug/ieee80211/phy0/rtw89/fw_log0. Each record
+# is a little-endian header followed by the raw firmware log text:
+#
+#   u16 magic (0x8952), u16 len, u32 seq, u64 ts_ns, u32 drop_cnt
+#
+# ts_ns uses the printk clock, so the output lines up with dmesg.
+
+import argparse
+import struct
+import sys
+import time
+
+REC_MAGIC = 0x8952
+REC_HDR = struct.Struct('<HHIQI')
+DEFAULT_PATH = '/sys/kernel/debug/ieee80211/phy0/rtw89/fw_log0'
+
+
+def records(stream, follow):
+    buf = b''
+
+    while True:
+        data = stream.read(65536)
+        if not data:
+            if not follow:
+                break
+            time.sleep(0.2)
+            continue
+        buf += data
+
+        while len(buf) >= REC_HDR.size:
+            magic, length, seq, ts_ns, drops = REC_HDR.unpack_from(buf)
+            if magic != REC_MAGIC:
+                # resync on the next magic
+                idx = buf.find(struct.pack('<H', REC_MAGIC), 1)
+                buf = buf[idx:] if idx > 0 else buf[-1:]
+                continue
+            if len(buf) < REC_HDR.size + length:
+                break
+            text = buf[REC_HDR.size:REC_HDR.size + length]
+            buf = buf[REC_HDR.size + length:]
+            yield seq, ts_ns, drops, text
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Decode rtw89 firmware logs')
+    parser.add_argument('path', nargs='?', default=DEFAULT_PATH,
+                        help='relay file or saved capture (default: %(default)s)')
+    parser.add_argument('-f', '--follow', action='store_true',
+                        help='keep reading as new records arrive')
+    args = parser.parse_args()
+
+    next_seq = None
+    lost = 0
+
+    with open(args.path, 'rb') as stream:
+        try:
+            for seq, ts_ns, drops, text in records(stream, args.follow):
+                if next_seq is not None and seq != next_seq:
+                    gap = (seq - next_seq) & 0xffffffff
+                    lost += gap
+                    print('-- %u record(s) dropped (driver total %u) --' %
+                          (gap, drops))
+                next_seq = (seq + 1) & 0xffffffff
+
+                msg = text.split(b'\0', 1)[0].decode('ascii', 'replace')
+                print('[%5u.%06u] #%u %s' % (ts_ns // 1000000000,
+                                             ts_ns % 1000000000 // 1000,
+                                             seq, msg.rstrip()))
+                sys.stdout.flush()
+        except KeyboardInterrupt:
+            pass
+
+    if lost:
+        print('-- %u record(s) dropped in total --' % lost, file=sys.stderr)
+
+
+if __name__ == '__main__':
+    main()
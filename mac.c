@@ -1028,6 +1028,8 @@ static int rtw89_mac_power_switch(struct rtw89_dev *rtwdev, bool on)
 	if (ret)
 		return ret;
 
+	rtw89_shadow_reset(rtwdev);
+
 	if (on) {
 		set_bit(RTW89_FLAG_POWERON, rtwdev->flags);
 		rtw89_write8(rtwdev, R_AX_SCOREBOARD + 3, MAC_AX_NOTIFY_TP_MAJOR);
@@ -3150,6 +3152,10 @@ rtw89_mac_c2h_done_ack(struct rtw89_dev *rtwdev, struct sk_buff *c2h, u32 len)
 static void
 rtw89_mac_c2h_log(struct rtw89_dev *rtwdev, struct sk_buff *c2h, u32 len)
 {
+	if (rtw89_fw_log_relay(rtwdev, RTW89_GET_C2H_LOG_SRT_PRT(c2h->data),
+			       RTW89_GET_C2H_LOG_LEN(len)))
+		return;
+
 	rtw89_info(rtwdev, "%*s", RTW89_GET_C2H_LOG_LEN(len),
 		   RTW89_GET_C2H_LOG_SRT_PRT(c2h->data));
 }
@@ -3178,6 +3184,29 @@ void (* const rtw89_mac_c2h_info_handler[])(struct rtw89_dev *rtwdev,
 	[RTW89_MAC_C2H_FUNC_BCN_CNT] = rtw89_mac_c2h_bcn_cnt,
 };
 
+/* C2Hs that only log or count and so can be handled without rtwdev->mutex */
+bool rtw89_mac_c2h_chk_atomic(u8 class, u8 func)
+{
+	switch (class) {
+	case RTW89_MAC_C2H_CLASS_INFO:
+		switch (func) {
+		case RTW89_MAC_C2H_FUNC_REC_ACK:
+		case RTW89_MAC_C2H_FUNC_DONE_ACK:
+		case RTW89_MAC_C2H_FUNC_C2H_LOG:
+		case RTW89_MAC_C2H_FUNC_BCN_CNT:
+			return true;
+		default:
+			return false;
+		}
+	case RTW89_MAC_C2H_CLASS_OFLD:
+		return func == RTW89_MAC_C2H_FUNC_MACID_PAUSE;
+	case RTW89_MAC_C2H_CLASS_FWDBG:
+		return true;
+	default:
+		return false;
+	}
+}
+
 void rtw89_mac_c2h_handle(struct rtw89_dev *rtwdev, struct sk_buff *skb,
 			  u32 len, u8 class, u8 func)
 {
@@ -26,7 +26,8 @@ static void rtw89_ops_tx(struct ieee80211_hw *hw,
 
 	ret = rtw89_core_tx_write(rtwdev, vif, sta, skb, &qsel);
 	if (ret) {
-		rtw89_err(rtwdev, "failed to transmit skb: %d\n", ret);
+		if (ret != -ENOSPC)
+			rtw89_err(rtwdev, "failed to transmit skb: %d\n", ret);
 		ieee80211_free_txskb(hw, skb);
 		return;
 	}
@@ -105,10 +106,16 @@ static int rtw89_ops_add_interface(struct ieee80211_hw *hw,
 	mutex_lock(&rtwdev->mutex);
 	rtwvif->rtwdev = rtwdev;
 	list_add_tail(&rtwvif->list, &rtwdev->rtwvifs_list);
-	INIT_WORK(&rtwvif->update_beacon_work, rtw89_core_update_beacon_work);
+	INIT_DELAYED_WORK(&rtwvif->update_beacon_work,
+			  rtw89_core_update_beacon_work);
+	/* mac80211 re-adds the interface on restart, drop the stale template */
+	rtw89_fw_bcn_cache_invalidate(rtwvif);
 	rtw89_leave_ps_mode(rtwdev);
 
-	rtw89_traffic_stats_init(rtwdev, &rtwvif->stats);
+	ret = rtw89_traffic_stats_init(rtwdev, &rtwvif->stats);
+	if (ret)
+		goto out;
+
 	rtw89_vif_type_mapping(vif, false);
 	rtwvif->port = rtw89_core_acquire_bit_map(rtwdev->hw_port,
 						  RTW89_MAX_HW_PORT_NUM);
@@ -133,6 +140,10 @@ static int rtw89_ops_add_interface(struct ieee80211_hw *hw,
 
 	rtw89_btc_ntfy_role_info(rtwdev, rtwvif, NULL, BTC_ROLE_START);
 out:
+	if (ret) {
+		list_del_init(&rtwvif->list);
+		rtw89_traffic_stats_deinit(rtwdev, &rtwvif->stats);
+	}
 	mutex_unlock(&rtwdev->mutex);
 
 	return ret;
@@ -144,14 +155,16 @@ static void rtw89_ops_remove_interface(struct ieee80211_hw *hw,
 	struct rtw89_dev *rtwdev = hw->priv;
 	struct rtw89_vif *rtwvif = (struct rtw89_vif *)vif->drv_priv;
 
-	cancel_work_sync(&rtwvif->update_beacon_work);
+	cancel_delayed_work_sync(&rtwvif->update_beacon_work);
 
 	mutex_lock(&rtwdev->mutex);
+	rtw89_fw_bcn_cache_invalidate(rtwvif);
 	rtw89_leave_ps_mode(rtwdev);
 	rtw89_btc_ntfy_role_info(rtwdev, rtwvif, NULL, BTC_ROLE_STOP);
 	rtw89_mac_remove_vif(rtwdev, rtwvif);
 	rtw89_core_release_bit_map(rtwdev->hw_port, rtwvif->port);
 	list_del_init(&rtwvif->list);
+	rtw89_traffic_stats_deinit(rtwdev, &rtwvif->stats);
 	mutex_unlock(&rtwdev->mutex);
 }
 
@@ -341,6 +354,7 @@ static void rtw89_ops_bss_info_changed(struct ieee80211_hw *hw,
 
 	mutex_lock(&rtwdev->mutex);
 	rtw89_leave_ps_mode(rtwdev);
+	rtw89_fw_h2c_batch_begin(rtwdev);
 
 	if (changed & BSS_CHANGED_ASSOC) {
 		if (conf->assoc) {
@@ -369,6 +383,7 @@ static void rtw89_ops_bss_info_changed(struct ieee80211_hw *hw,
 	if (changed & BSS_CHANGED_MU_GROUPS)
 		rtw89_mac_bf_set_gid_table(rtwdev, vif, conf);
 
+	rtw89_fw_h2c_batch_end(rtwdev);
 	mutex_unlock(&rtwdev->mutex);
 }
 
@@ -378,6 +393,7 @@ static int rtw89_ops_start_ap(struct ieee80211_hw *hw, struct ieee80211_vif *vif
 	struct rtw89_vif *rtwvif = (struct rtw89_vif *)vif->drv_priv;
 
 	mutex_lock(&rtwdev->mutex);
+	rtw89_fw_bcn_cache_invalidate(rtwvif);
 	ether_addr_copy(rtwvif->bssid, vif->bss_conf.bssid);
 	rtw89_cam_bssid_changed(rtwdev, rtwvif);
 	rtw89_mac_port_update(rtwdev, rtwvif);
@@ -400,6 +416,7 @@ void rtw89_ops_stop_ap(struct ieee80211_hw *hw, struct ieee80211_vif *vif)
 	mutex_lock(&rtwdev->mutex);
 	rtw89_fw_h2c_assoc_cmac_tbl(rtwdev, vif, NULL);
 	rtw89_fw_h2c_join_info(rtwdev, rtwvif, NULL, true);
+	rtw89_fw_bcn_cache_invalidate(rtwvif);
 	mutex_unlock(&rtwdev->mutex);
 }
 
@@ -409,8 +426,18 @@ static int rtw89_ops_set_tim(struct ieee80211_hw *hw, struct ieee80211_sta *sta,
 	struct rtw89_dev *rtwdev = hw->priv;
 	struct rtw89_sta *rtwsta = (struct rtw89_sta *)sta->drv_priv;
 	struct rtw89_vif *rtwvif = rtwsta->rtwvif;
+	struct ieee80211_vif *vif = rtwvif_to_vif(rtwvif);
+	unsigned long next;
+	unsigned long delay = 0;
+
+	/* coalesce TIM changes into at most one update per beacon interval */
+	next = rtwvif->bcn_cache.last_upd +
+	       usecs_to_jiffies(ieee80211_tu_to_usec(vif->bss_conf.beacon_int));
+	if (rtwvif->bcn_cache.skb && time_before(jiffies, next))
+		delay = next - jiffies;
 
-	ieee80211_queue_work(rtwdev->hw, &rtwvif->update_beacon_work);
+	ieee80211_queue_delayed_work(rtwdev->hw, &rtwvif->update_beacon_work,
+				     delay);
 
 	return 0;
 }
@@ -476,7 +503,9 @@ static int rtw89_ops_sta_state(struct ieee80211_hw *hw,
 
 	mutex_lock(&rtwdev->mutex);
 	rtw89_leave_ps_mode(rtwdev);
+	rtw89_fw_h2c_batch_begin(rtwdev);
 	ret = __rtw89_ops_sta_state(hw, vif, sta, old_state, new_state);
+	rtw89_fw_h2c_batch_end(rtwdev);
 	mutex_unlock(&rtwdev->mutex);
 
 	return ret;
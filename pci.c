@@ -4,6 +4,7 @@
 
 #include <linux/pci.h>
 
+#include "fw.h"
 #include "mac.h"
 #include "pci.h"
 #include "reg.h"
@@ -331,6 +332,16 @@ static int rtw89_pci_poll_rxq_dma(struct rtw89_dev *rtwdev,
 	return budget - countdown;
 }
 
+static void rtw89_pci_tx_ll_status(struct rtw89_dev *rtwdev,
+				   struct sk_buff *skb, u8 tx_status)
+{
+	struct rtw89_pci_tx_data *tx_data = RTW89_PCI_TX_SKB_CB(skb);
+	u32 lat_us;
+
+	lat_us = ktime_us_delta(ktime_get(), tx_data->submit_time);
+	rtw89_tx_ll_stats_done(rtwdev, tx_status == RTW89_TX_DONE, lat_us);
+}
+
 static void rtw89_pci_tx_status(struct rtw89_dev *rtwdev,
 				struct rtw89_pci_tx_ring *tx_ring,
 				struct sk_buff *skb, u8 tx_status)
@@ -338,6 +349,8 @@ static void rtw89_pci_tx_status(struct rtw89_dev *rtwdev,
 	struct ieee80211_tx_info *info;
 
 	info = IEEE80211_SKB_CB(skb);
+	if (tx_ring->txch == RTW89_TXCH_CH8)
+		rtw89_pci_tx_ll_status(rtwdev, skb, tx_status);
 	ieee80211_tx_info_clear_status(info);
 
 	if (info->flags & IEEE80211_TX_CTL_NO_ACK)
@@ -558,10 +571,72 @@ static void rtw89_pci_release_tx(struct rtw89_dev *rtwdev,
 	rtw89_write16(rtwdev, bd_ring->addr_idx, bd_ring->wp);
 }
 
+static u32 rtw89_pci_get_avail_txbd_num(struct rtw89_pci_tx_ring *ring)
+{
+	struct rtw89_pci_dma_ring *bd_ring = &ring->bd_ring;
+
+	/* reserved 1 desc check ring is full or not */
+	if (bd_ring->rp > bd_ring->wp)
+		return bd_ring->rp - bd_ring->wp - 1;
+
+	return bd_ring->len - (bd_ring->wp - bd_ring->rp) - 1;
+}
+
+static u32 rtw89_pci_get_avail_tx_num(struct rtw89_pci_tx_ring *ring)
+{
+	return min(rtw89_pci_get_avail_txbd_num(ring), ring->wd_ring.curr_num);
+}
+
+static bool rtw89_pci_tx_ring_should_stop(struct rtw89_pci_tx_ring *tx_ring)
+{
+	if (tx_ring->stopped ||
+	    rtw89_core_get_ac_by_ch_dma(tx_ring->txch) >= IEEE80211_NUM_ACS)
+		return false;
+
+	if (rtw89_pci_get_avail_tx_num(tx_ring) > RTW89_PCI_TX_STOP_THRES)
+		return false;
+
+	tx_ring->stopped = true;
+	return true;
+}
+
+/* must be called with trx_lock held, returns the channels to wake */
+static u32 rtw89_pci_tx_rings_to_wake(struct rtw89_pci *rtwpci)
+{
+	struct rtw89_pci_tx_ring *tx_ring;
+	u32 wake_chs = 0;
+	int txch;
+
+	for (txch = 0; txch < RTW89_TXCH_NUM; txch++) {
+		tx_ring = &rtwpci->tx_rings[txch];
+		if (!tx_ring->stopped)
+			continue;
+
+		if (rtw89_pci_get_avail_tx_num(tx_ring) < RTW89_PCI_TX_WAKE_THRES)
+			continue;
+
+		tx_ring->stopped = false;
+		wake_chs |= BIT(txch);
+	}
+
+	return wake_chs;
+}
+
+static void rtw89_pci_wake_tx_rings(struct rtw89_dev *rtwdev, u32 wake_chs)
+{
+	int txch;
+
+	for (txch = 0; txch < RTW89_TXCH_NUM; txch++) {
+		if (wake_chs & BIT(txch))
+			rtw89_core_wake_tx_ch(rtwdev, txch);
+	}
+}
+
 static int rtw89_pci_poll_rpq_dma(struct rtw89_dev *rtwdev,
 				  struct rtw89_pci *rtwpci, int budget)
 {
 	struct rtw89_pci_rx_ring *rx_ring;
+	u32 wake_chs = 0;
 	u32 cnt;
 	int work_done;
 
@@ -574,10 +649,13 @@ static int rtw89_pci_poll_rpq_dma(struct rtw89_dev *rtwdev,
 		goto out_unlock;
 
 	rtw89_pci_release_tx(rtwdev, rx_ring, cnt);
+	wake_chs = rtw89_pci_tx_rings_to_wake(rtwpci);
 
 out_unlock:
 	spin_unlock_bh(&rtwpci->trx_lock);
 
+	rtw89_pci_wake_tx_rings(rtwdev, wake_chs);
+
 	/* always release all RPQ */
 	work_done = min_t(int, cnt, budget);
 	rtwdev->napi_budget_countdown -= work_done;
@@ -619,8 +697,13 @@ static void rtw89_pci_recognize_intrs(struct rtw89_dev *rtwdev,
 	isrs->halt_c2h_isrs = rtw89_read32(rtwdev, R_AX_HISR0) & rtwpci->halt_c2h_intrs;
 	isrs->isrs[0] = rtw89_read32(rtwdev, R_AX_PCIE_HISR00) & rtwpci->intrs[0];
 	isrs->isrs[1] = rtw89_read32(rtwdev, R_AX_PCIE_HISR10) & rtwpci->intrs[1];
+	isrs->hd0_isrs = 0;
+	if (isrs->isrs[0] & B_AX_HD0ISR_IND_INT)
+		isrs->hd0_isrs = rtw89_read32(rtwdev, R_AX_HD0ISR) & rtwpci->hd0_intrs;
 
 	rtw89_write32(rtwdev, R_AX_HISR0, isrs->halt_c2h_isrs);
+	if (isrs->hd0_isrs)
+		rtw89_write32(rtwdev, R_AX_HD0ISR, isrs->hd0_isrs);
 	rtw89_write32(rtwdev, R_AX_PCIE_HISR00, isrs->isrs[0]);
 	rtw89_write32(rtwdev, R_AX_PCIE_HISR10, isrs->isrs[1]);
 }
@@ -664,6 +747,9 @@ static irqreturn_t rtw89_pci_interrupt_threadfn(int irq, void *dev)
 	if (unlikely(isrs.halt_c2h_isrs & B_AX_HALT_C2H_INT_EN))
 		rtw89_ser_notify(rtwdev, rtw89_mac_get_err_status(rtwdev));
 
+	if (isrs.hd0_isrs & B_AX_C2H_INT)
+		rtw89_fw_c2h_reg_irqsafe(rtwdev);
+
 	if (likely(rtwpci->running)) {
 		local_bh_disable();
 		napi_schedule(&rtwdev->napi);
@@ -762,17 +848,6 @@ static int rtw89_pci_get_rxch_addrs(enum rtw89_rx_channel rxch,
 
 #undef case_RXCHADDRS
 
-static u32 rtw89_pci_get_avail_txbd_num(struct rtw89_pci_tx_ring *ring)
-{
-	struct rtw89_pci_dma_ring *bd_ring = &ring->bd_ring;
-
-	/* reserved 1 desc check ring is full or not */
-	if (bd_ring->rp > bd_ring->wp)
-		return bd_ring->rp - bd_ring->wp - 1;
-
-	return bd_ring->len - (bd_ring->wp - bd_ring->rp) - 1;
-}
-
 static
 u32 __rtw89_pci_check_and_reclaim_tx_fwcmd_resource(struct rtw89_dev *rtwdev)
 {
@@ -788,39 +863,38 @@ u32 __rtw89_pci_check_and_reclaim_tx_fwcmd_resource(struct rtw89_dev *rtwdev)
 	return cnt;
 }
 
-static u32 __rtw89_pci_check_and_reclaim_tx_resource(struct rtw89_dev *rtwdev,
-						     u8 txch)
+static void rtw89_pci_kick_tx_reclaim(struct rtw89_dev *rtwdev)
 {
 	struct rtw89_pci *rtwpci = (struct rtw89_pci *)rtwdev->priv;
-	struct rtw89_pci_tx_ring *tx_ring = &rtwpci->tx_rings[txch];
-	struct rtw89_pci_tx_wd_ring *wd_ring = &tx_ring->wd_ring;
-	u32 bd_cnt, wd_cnt, min_cnt = 0;
-	struct rtw89_pci_rx_ring *rx_ring;
-	u32 cnt;
 
-	rx_ring = &rtwpci->rx_rings[RTW89_RXCH_RPQ];
-
-	spin_lock_bh(&rtwpci->trx_lock);
-	bd_cnt = rtw89_pci_get_avail_txbd_num(tx_ring);
-	wd_cnt = wd_ring->curr_num;
+	if (unlikely(!rtwpci->running))
+		return;
 
-	if (wd_cnt == 0 || bd_cnt == 0) {
-		cnt = rtw89_pci_rxbd_recalc(rtwdev, rx_ring);
-		if (!cnt)
-			goto out_unlock;
-		rtw89_pci_release_tx(rtwdev, rx_ring, cnt);
-	}
+	/* RPQ can be held by interrupt mitigation under high traffic, so
+	 * let NAPI consume the release reports now.
+	 */
+	local_bh_disable();
+	napi_schedule(&rtwdev->napi);
+	local_bh_enable();
+}
 
-	bd_cnt = rtw89_pci_get_avail_txbd_num(tx_ring);
-	wd_cnt = wd_ring->curr_num;
-	min_cnt = min(bd_cnt, wd_cnt);
-	if (min_cnt == 0)
-		rtw89_warn(rtwdev, "still no tx resource after reclaim\n");
+static u32 __rtw89_pci_check_tx_resource(struct rtw89_dev *rtwdev, u8 txch)
+{
+	struct rtw89_pci *rtwpci = (struct rtw89_pci *)rtwdev->priv;
+	struct rtw89_pci_tx_ring *tx_ring = &rtwpci->tx_rings[txch];
+	u32 cnt;
 
-out_unlock:
+	/* Release reports are consumed by NAPI only, here is just a snapshot
+	 * of what is left. Stopped queues are woken up by NAPI.
+	 */
+	spin_lock_bh(&rtwpci->trx_lock);
+	cnt = rtw89_pci_get_avail_tx_num(tx_ring);
 	spin_unlock_bh(&rtwpci->trx_lock);
 
-	return min_cnt;
+	if (cnt <= RTW89_PCI_TX_STOP_THRES)
+		rtw89_pci_kick_tx_reclaim(rtwdev);
+
+	return cnt;
 }
 
 static u32 rtw89_pci_check_and_reclaim_tx_resource(struct rtw89_dev *rtwdev,
@@ -829,7 +903,7 @@ static u32 rtw89_pci_check_and_reclaim_tx_resource(struct rtw89_dev *rtwdev,
 	if (txch == RTW89_TXCH_CH12)
 		return __rtw89_pci_check_and_reclaim_tx_fwcmd_resource(rtwdev);
 
-	return __rtw89_pci_check_and_reclaim_tx_resource(rtwdev, txch);
+	return __rtw89_pci_check_tx_resource(rtwdev, txch);
 }
 
 static void __rtw89_pci_tx_kick_off(struct rtw89_dev *rtwdev, struct rtw89_pci_tx_ring *tx_ring)
@@ -943,6 +1017,8 @@ static int rtw89_pci_txwd_submit(struct rtw89_dev *rtwdev,
 	}
 
 	tx_data->dma = dma;
+	if (tx_ring->txch == RTW89_TXCH_CH8)
+		tx_data->submit_time = ktime_get();
 
 	txaddr_info_len = sizeof(*txaddr_info);
 	txwp_len = sizeof(*txwp_info);
@@ -1023,7 +1099,7 @@ static int rtw89_pci_txbd_submit(struct rtw89_dev *rtwdev,
 
 	txwd = rtw89_pci_dequeue_txwd(tx_ring);
 	if (!txwd) {
-		rtw89_err(rtwdev, "no available TXWD\n");
+		rtw89_debug(rtwdev, RTW89_DBG_TXRX, "no available TXWD\n");
 		ret = -ENOSPC;
 		goto err;
 	}
@@ -1057,6 +1133,7 @@ static int rtw89_pci_tx_write(struct rtw89_dev *rtwdev, struct rtw89_core_tx_req
 	struct rtw89_pci_tx_ring *tx_ring;
 	struct rtw89_pci_tx_bd_32 *txbd;
 	u32 n_avail_txbd;
+	bool stop;
 	int ret = 0;
 
 	/* check the tx type and dma channel for fw cmd queue */
@@ -1073,21 +1150,37 @@ static int rtw89_pci_tx_write(struct rtw89_dev *rtwdev, struct rtw89_core_tx_req
 
 	n_avail_txbd = rtw89_pci_get_avail_txbd_num(tx_ring);
 	if (n_avail_txbd == 0) {
-		rtw89_err(rtwdev, "no available TXBD\n");
+		rtw89_debug(rtwdev, RTW89_DBG_TXRX, "no available TXBD\n");
 		ret = -ENOSPC;
-		goto err_unlock;
+		goto err_stop;
 	}
 
 	txbd = rtw89_pci_get_next_txbd(tx_ring);
 	ret = rtw89_pci_txbd_submit(rtwdev, tx_ring, txbd, tx_req);
-	if (ret) {
+	if (ret == -ENOSPC) {
+		goto err_stop;
+	} else if (ret) {
 		rtw89_err(rtwdev, "failed to submit TXBD\n");
 		goto err_unlock;
 	}
 
+	stop = rtw89_pci_tx_ring_should_stop(tx_ring);
 	spin_unlock_bh(&rtwpci->trx_lock);
+
+	if (stop)
+		rtw89_core_stop_tx_ch(rtwdev, txch);
+
 	return 0;
 
+err_stop:
+	stop = rtw89_pci_tx_ring_should_stop(tx_ring);
+	spin_unlock_bh(&rtwpci->trx_lock);
+
+	if (stop)
+		rtw89_core_stop_tx_ch(rtwdev, txch);
+
+	return ret;
+
 err_unlock:
 	spin_unlock_bh(&rtwpci->trx_lock);
 	return ret;
@@ -1100,7 +1193,9 @@ static int rtw89_pci_ops_tx_write(struct rtw89_dev *rtwdev, struct rtw89_core_tx
 
 	ret = rtw89_pci_tx_write(rtwdev, tx_req, desc_info->ch_dma);
 	if (ret) {
-		rtw89_err(rtwdev, "failed to TX Queue %d\n", desc_info->ch_dma);
+		if (ret != -ENOSPC)
+			rtw89_err(rtwdev, "failed to TX Queue %d\n",
+				  desc_info->ch_dma);
 		return ret;
 	}
 
@@ -1180,6 +1275,7 @@ static void rtw89_pci_release_tx_ring(struct rtw89_dev *rtwdev,
 static void rtw89_pci_ops_reset(struct rtw89_dev *rtwdev)
 {
 	struct rtw89_pci *rtwpci = (struct rtw89_pci *)rtwdev->priv;
+	u32 wake_chs;
 	int txch;
 
 	rtw89_pci_reset_trx_rings(rtwdev);
@@ -1193,7 +1289,10 @@ static void rtw89_pci_ops_reset(struct rtw89_dev *rtwdev)
 		}
 		rtw89_pci_release_tx_ring(rtwdev, &rtwpci->tx_rings[txch]);
 	}
+	wake_chs = rtw89_pci_tx_rings_to_wake(rtwpci);
 	spin_unlock_bh(&rtwpci->trx_lock);
+
+	rtw89_pci_wake_tx_rings(rtwdev, wake_chs);
 }
 
 static int rtw89_pci_ops_start(struct rtw89_dev *rtwdev)
@@ -1205,9 +1304,12 @@ static int rtw89_pci_ops_start(struct rtw89_dev *rtwdev)
 
 	spin_lock_irqsave(&rtwpci->irq_lock, flags);
 	rtwpci->running = true;
+	rtw89_write32_set(rtwdev, R_AX_HD0IMR, rtwpci->hd0_intrs);
 	rtw89_pci_enable_intr(rtwdev, rtwpci);
 	spin_unlock_irqrestore(&rtwpci->irq_lock, flags);
 
+	rtw89_fw_c2h_reg_irq_ready(rtwdev, true);
+
 	return 0;
 }
 
@@ -1217,9 +1319,12 @@ static void rtw89_pci_ops_stop(struct rtw89_dev *rtwdev)
 	struct pci_dev *pdev = rtwpci->pdev;
 	unsigned long flags;
 
+	rtw89_fw_c2h_reg_irq_ready(rtwdev, false);
+
 	spin_lock_irqsave(&rtwpci->irq_lock, flags);
 	rtwpci->running = false;
 	rtw89_pci_disable_intr(rtwdev, rtwpci);
+	rtw89_write32_clr(rtwdev, R_AX_HD0IMR, rtwpci->hd0_intrs);
 	spin_unlock_irqrestore(&rtwpci->irq_lock, flags);
 
 	synchronize_irq(pdev->irq);
@@ -1988,6 +2093,7 @@ static int rtw89_pci_setup_mapping(struct rtw89_dev *rtwdev,
 		ret = -EIO;
 		goto err_release_regions;
 	}
+	rtwdev->hci.mmio = rtwpci->mmap;
 
 	return 0;
 
@@ -2003,6 +2109,7 @@ static void rtw89_pci_clear_mapping(struct rtw89_dev *rtwdev,
 	struct rtw89_pci *rtwpci = (struct rtw89_pci *)rtwdev->priv;
 
 	if (rtwpci->mmap) {
+		rtwdev->hci.mmio = NULL;
 		pci_iounmap(pdev, rtwpci->mmap);
 		pci_release_regions(pdev);
 	}
@@ -2472,6 +2579,7 @@ static void rtw89_pci_default_intr_mask(struct rtw89_dev *rtwdev)
 	struct rtw89_pci *rtwpci = (struct rtw89_pci *)rtwdev->priv;
 
 	rtwpci->halt_c2h_intrs = B_AX_HALT_C2H_INT_EN | 0;
+	rtwpci->hd0_intrs = B_AX_C2H_INT_EN;
 	rtwpci->intrs[0] = B_AX_TXDMA_STUCK_INT_EN |
 			   B_AX_RXDMA_INT_EN |
 			   B_AX_RXP1DMA_INT_EN |
@@ -2479,6 +2587,7 @@ static void rtw89_pci_default_intr_mask(struct rtw89_dev *rtwdev)
 			   B_AX_RXDMA_STUCK_INT_EN |
 			   B_AX_RDU_INT_EN |
 			   B_AX_RPQBD_FULL_INT_EN |
+			   B_AX_HD0ISR_IND_INT_EN |
 			   B_AX_HS0ISR_IND_INT_EN;
 
 	rtwpci->intrs[1] = B_AX_HC10ISR_IND_INT_EN;
@@ -325,6 +325,10 @@
 #define RTW89_PCI_ADDRINFO_MAX		4
 #define RTW89_PCI_RX_BUF_SIZE		11460
 
+/* stop/wake the mac80211 queue of an AC channel with hysteresis */
+#define RTW89_PCI_TX_STOP_THRES		8
+#define RTW89_PCI_TX_WAKE_THRES		64
+
 #define RTW89_PCI_POLL_BDRAM_RST_CNT	100
 #define RTW89_PCI_MULTITAG		8
 
@@ -390,6 +394,7 @@ struct rtw89_pci_bd_ram {
 
 struct rtw89_pci_tx_data {
 	dma_addr_t dma;
+	ktime_t submit_time; /* low-latency channel only */
 };
 
 struct rtw89_pci_rx_info {
@@ -501,6 +506,7 @@ struct rtw89_pci_tx_ring {
 	u8 txch;
 	bool dma_enabled;
 	u16 tag; /* range from 0x0001 ~ 0x1fff */
+	bool stopped;
 
 	u64 tx_cnt;
 	u64 tx_acked;
@@ -519,6 +525,7 @@ struct rtw89_pci_rx_ring {
 
 struct rtw89_pci_isrs {
 	u32 halt_c2h_isrs;
+	u32 hd0_isrs;
 	u32 isrs[2];
 };
 
@@ -536,6 +543,7 @@ struct rtw89_pci {
 	struct sk_buff_head h2c_release_queue;
 
 	u32 halt_c2h_intrs;
+	u32 hd0_intrs;
 	u32 intrs[2];
 	void __iomem *mmap;
 };
@@ -2,6 +2,7 @@
 /* Copyright(c) 2019-2020  Realtek Corporation
  */
 
+#include <linux/crc32.h>
 #include <linux/version.h>
 #include "debug.h"
 #include "fw.h"
@@ -582,6 +583,7 @@ u32 rtw89_phy_read_rf(struct rtw89_dev *rtwdev, enum rtw89_rf_path rf_path,
 	const struct rtw89_chip_info *chip = rtwdev->chip;
 	const u32 *base_addr = chip->rf_base_addr;
 	u32 val, direct_addr;
+	bool tagged;
 
 	if (rf_path >= rtwdev->chip->rf_path_num) {
 		rtw89_err(rtwdev, "unsupported rf path (%d)\n", rf_path);
@@ -592,14 +594,17 @@ u32 rtw89_phy_read_rf(struct rtw89_dev *rtwdev, enum rtw89_rf_path rf_path,
 	direct_addr = base_addr[rf_path] + (addr << 2);
 	mask &= RFREG_MASK;
 
+	tagged = rtw89_mmio_prof_tag(rtwdev, _RET_IP_);
 	val = rtw89_phy_read32_mask(rtwdev, direct_addr, mask);
+	rtw89_mmio_prof_untag(rtwdev, tagged);
 
 	return val;
 }
 EXPORT_SYMBOL(rtw89_phy_read_rf);
 
-bool rtw89_phy_write_rf(struct rtw89_dev *rtwdev, enum rtw89_rf_path rf_path,
-			u32 addr, u32 mask, u32 data)
+static bool __rtw89_phy_write_rf(struct rtw89_dev *rtwdev,
+				 enum rtw89_rf_path rf_path,
+				 u32 addr, u32 mask, u32 data)
 {
 	const struct rtw89_chip_info *chip = rtwdev->chip;
 	const u32 *base_addr = chip->rf_base_addr;
@@ -616,6 +621,34 @@ bool rtw89_phy_write_rf(struct rtw89_dev *rtwdev, enum rtw89_rf_path rf_path,
 
 	rtw89_phy_write32_mask(rtwdev, direct_addr, mask, data);
 
+	return true;
+}
+
+bool rtw89_phy_write_rf_nodelay(struct rtw89_dev *rtwdev,
+				enum rtw89_rf_path rf_path,
+				u32 addr, u32 mask, u32 data)
+{
+	bool tagged = rtw89_mmio_prof_tag(rtwdev, _RET_IP_);
+	bool ret;
+
+	ret = __rtw89_phy_write_rf(rtwdev, rf_path, addr, mask, data);
+	rtw89_mmio_prof_untag(rtwdev, tagged);
+
+	return ret;
+}
+EXPORT_SYMBOL(rtw89_phy_write_rf_nodelay);
+
+bool rtw89_phy_write_rf(struct rtw89_dev *rtwdev, enum rtw89_rf_path rf_path,
+			u32 addr, u32 mask, u32 data)
+{
+	bool tagged = rtw89_mmio_prof_tag(rtwdev, _RET_IP_);
+	bool ret;
+
+	ret = __rtw89_phy_write_rf(rtwdev, rf_path, addr, mask, data);
+	rtw89_mmio_prof_untag(rtwdev, tagged);
+	if (!ret)
+		return false;
+
 	/* delay to ensure writing properly */
 	udelay(1);
 
@@ -631,24 +664,43 @@ static void rtw89_phy_bb_reset(struct rtw89_dev *rtwdev,
 	chip->ops->bb_reset(rtwdev, phy_idx);
 }
 
+/* table entries at 0xf9..0xfe are delays rather than registers */
+static bool rtw89_phy_is_table_delay(u32 addr)
+{
+	return addr >= 0xf9 && addr <= 0xfe;
+}
+
+/* Anything from 10 us up sleeps; the time slept is accounted to the
+ * replay.
+ */
+static bool rtw89_phy_table_delay(struct rtw89_dev *rtwdev, u32 addr)
+{
+	static const u32 delay_us[] = {1, 5, 50, 1000, 5000, 50000};
+	ktime_t start;
+	u32 us;
+
+	if (!rtw89_phy_is_table_delay(addr))
+		return false;
+
+	us = delay_us[addr - 0xf9];
+	if (us < 10) {
+		udelay(us);
+		return true;
+	}
+
+	start = ktime_get();
+	fsleep_alt(us);
+	rtwdev->phy_flat.sleep_ns += ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	return true;
+}
+
 static void rtw89_phy_config_bb_reg(struct rtw89_dev *rtwdev,
 				    const struct rtw89_reg2_def *reg,
 				    enum rtw89_rf_path rf_path,
 				    void *extra_data)
 {
-	if (reg->addr == 0xfe)
-		mdelay(50);
-	else if (reg->addr == 0xfd)
-		mdelay(5);
-	else if (reg->addr == 0xfc)
-		mdelay(1);
-	else if (reg->addr == 0xfb)
-		udelay(50);
-	else if (reg->addr == 0xfa)
-		udelay(5);
-	else if (reg->addr == 0xf9)
-		udelay(1);
-	else
+	if (!rtw89_phy_table_delay(rtwdev, reg->addr))
 		rtw89_phy_write32(rtwdev, reg->addr, reg->data);
 }
 
@@ -700,84 +752,220 @@ out:
 	return ret;
 }
 
+#define RTW89_RF_WRITE_GAP_NS 1000
+
+/* Each RF write needs 1 us before the next one. The read-modify-write of
+ * the following entry usually takes that long already, so wait only for
+ * whatever is left instead of a fixed udelay() after every write. Chips
+ * without a write_rf_nodelay op keep the delay of their write_rf.
+ */
+static void rtw89_phy_table_write_rf(struct rtw89_dev *rtwdev,
+				     enum rtw89_rf_path rf_path,
+				     u32 addr, u32 data)
+{
+	const struct rtw89_chip_ops *ops = rtwdev->chip->ops;
+	struct rtw89_phy_flat_tables *tables = &rtwdev->phy_flat;
+	u64 gap;
+
+	if (!ops->write_rf_nodelay) {
+		rtw89_write_rf(rtwdev, rf_path, addr, RFREG_MASK, data);
+		return;
+	}
+
+	gap = ktime_get_ns() - tables->rf_write_ns;
+	if (gap < RTW89_RF_WRITE_GAP_NS)
+		ndelay(RTW89_RF_WRITE_GAP_NS - gap);
+
+	mutex_lock(&rtwdev->rf_mutex);
+	ops->write_rf_nodelay(rtwdev, rf_path, addr, RFREG_MASK, data);
+	mutex_unlock(&rtwdev->rf_mutex);
+
+	tables->rf_write_ns = ktime_get_ns();
+}
+
 static void rtw89_phy_config_rf_reg(struct rtw89_dev *rtwdev,
 				    const struct rtw89_reg2_def *reg,
 				    enum rtw89_rf_path rf_path,
 				    void *extra_data)
 {
-	if (reg->addr == 0xfe) {
-		mdelay(50);
-	} else if (reg->addr == 0xfd) {
-		mdelay(5);
-	} else if (reg->addr == 0xfc) {
-		mdelay(1);
-	} else if (reg->addr == 0xfb) {
-		udelay(50);
-	} else if (reg->addr == 0xfa) {
-		udelay(5);
-	} else if (reg->addr == 0xf9) {
-		udelay(1);
-	} else {
-		rtw89_write_rf(rtwdev, rf_path, reg->addr, 0xfffff, reg->data);
-		rtw89_phy_cofig_rf_reg_store(rtwdev, reg, rf_path,
-					     (struct rtw89_fw_h2c_rf_reg_info *)extra_data);
+	if (rtw89_phy_table_delay(rtwdev, reg->addr))
+		return;
+
+	rtw89_phy_table_write_rf(rtwdev, rf_path, reg->addr, reg->data);
+	rtw89_phy_cofig_rf_reg_store(rtwdev, reg, rf_path,
+				     (struct rtw89_fw_h2c_rf_reg_info *)extra_data);
+}
+
+struct rtw89_phy_table_iter {
+	const struct rtw89_phy_table *table;
+	u32 idx;
+	u32 pos;
+	/* last register write decoded from a packed table */
+	struct rtw89_reg2_def reg;
+	int err;
+};
+
+static u32 rtw89_phy_table_size(const struct rtw89_phy_table *table)
+{
+	return table->regs ? table->n_regs : table->packed->n_regs;
+}
+
+static void rtw89_phy_table_iter_init(struct rtw89_phy_table_iter *iter,
+				      const struct rtw89_phy_table *table)
+{
+	memset(iter, 0, sizeof(*iter));
+	iter->table = table;
+}
+
+static bool rtw89_phy_table_get_varint(struct rtw89_phy_table_iter *iter,
+				       u32 *val)
+{
+	const struct rtw89_phy_packed_table *packed = iter->table->packed;
+	u8 byte;
+	int i;
+
+	*val = 0;
+	for (i = 0; i < 5 && iter->pos < packed->len; i++) {
+		byte = packed->data[iter->pos++];
+		*val |= (u32)(byte & 0x7f) << (7 * i);
+		if (!(byte & 0x80))
+			return true;
 	}
+
+	return false;
+}
+
+/* Return the next entry of the table, or NULL at its end. Packed tables are
+ * decoded on the fly; the stream is checked against its bounds, and a
+ * malformed one ends the walk with iter->err set.
+ */
+static const struct rtw89_reg2_def *
+rtw89_phy_table_next(struct rtw89_phy_table_iter *iter)
+{
+	const struct rtw89_phy_table *table = iter->table;
+	const struct rtw89_phy_packed_table *packed = table->packed;
+	struct rtw89_reg2_def *reg = &iter->reg;
+	u32 delta;
+	u8 tag, mode, n;
+
+	if (iter->err || iter->idx >= rtw89_phy_table_size(table))
+		return NULL;
+
+	if (table->regs)
+		return &table->regs[iter->idx++];
+
+	if (iter->pos >= packed->len)
+		goto err;
+
+	tag = packed->data[iter->pos++];
+	if (tag >= RTW89_PHY_PACK_COND) {
+		n = tag - RTW89_PHY_PACK_COND;
+		if (n >= packed->n_conds)
+			goto err;
+		iter->idx++;
+		return &packed->conds[n];
+	}
+
+	switch (FIELD_GET(RTW89_PHY_PACK_ADDR, tag)) {
+	case RTW89_PHY_PACK_ADDR_SAME:
+		break;
+	case RTW89_PHY_PACK_ADDR_NEXT:
+		reg->addr += packed->stride;
+		break;
+	case RTW89_PHY_PACK_ADDR_DELTA:
+		if (!rtw89_phy_table_get_varint(iter, &delta))
+			goto err;
+		/* zigzag encoded, so small negative steps stay short */
+		reg->addr += ((delta >> 1) ^ -(delta & 1)) * packed->stride;
+		break;
+	default:
+		goto err;
+	}
+
+	mode = FIELD_GET(RTW89_PHY_PACK_DATA, tag);
+	if (mode <= RTW89_PHY_PACK_DATA_LIT_MAX) {
+		reg->data = mode;
+	} else if (mode != RTW89_PHY_PACK_DATA_PREV) {
+		n = mode - RTW89_PHY_PACK_DATA_LIT_MAX;
+		if (packed->len - iter->pos < n)
+			goto err;
+		reg->data = 0;
+		while (n--)
+			reg->data |= (u32)packed->data[iter->pos + n] << (8 * n);
+		iter->pos += mode - RTW89_PHY_PACK_DATA_LIT_MAX;
+	}
+
+	iter->idx++;
+	return reg;
+
+err:
+	iter->err = -EINVAL;
+	return NULL;
+}
+
+static const struct rtw89_reg2_def *
+rtw89_phy_headline_next(struct rtw89_phy_table_iter *iter, u32 headline_size)
+{
+	if (iter->idx >= headline_size)
+		return NULL;
+
+	return rtw89_phy_table_next(iter);
 }
 
 static int rtw89_phy_sel_headline(struct rtw89_dev *rtwdev,
 				  const struct rtw89_phy_table *table,
-				  u32 *headline_size, u32 *headline_idx,
+				  u32 *headline_size, u32 *headline_addr,
 				  u8 rfe, u8 cv)
 {
 	const struct rtw89_reg2_def *reg;
+	struct rtw89_phy_table_iter iter;
 	u32 headline;
 	u32 compare, target;
 	u8 rfe_para, cv_para;
 	u8 cv_max = 0;
 	bool case_matched = false;
-	u32 i;
 
-	for (i = 0; i < table->n_regs; i++) {
-		reg = &table->regs[i];
+	rtw89_phy_table_iter_init(&iter, table);
+	while ((reg = rtw89_phy_table_next(&iter))) {
 		headline = get_phy_headline(reg->addr);
 		if (headline != PHY_HEADLINE_VALID)
 			break;
 	}
-	*headline_size = i;
+	*headline_size = reg ? iter.idx - 1 : iter.idx;
 	if (*headline_size == 0)
 		return 0;
 
 	/* case 1: RFE match, CV match */
 	compare = get_phy_compare(rfe, cv);
-	for (i = 0; i < *headline_size; i++) {
-		reg = &table->regs[i];
+	rtw89_phy_table_iter_init(&iter, table);
+	while ((reg = rtw89_phy_headline_next(&iter, *headline_size))) {
 		target = get_phy_target(reg->addr);
 		if (target == compare) {
-			*headline_idx = i;
+			*headline_addr = reg->addr;
 			return 0;
 		}
 	}
 
 	/* case 2: RFE match, CV don't care */
 	compare = get_phy_compare(rfe, PHY_COND_DONT_CARE);
-	for (i = 0; i < *headline_size; i++) {
-		reg = &table->regs[i];
+	rtw89_phy_table_iter_init(&iter, table);
+	while ((reg = rtw89_phy_headline_next(&iter, *headline_size))) {
 		target = get_phy_target(reg->addr);
 		if (target == compare) {
-			*headline_idx = i;
+			*headline_addr = reg->addr;
 			return 0;
 		}
 	}
 
 	/* case 3: RFE match, CV max in table */
-	for (i = 0; i < *headline_size; i++) {
-		reg = &table->regs[i];
+	rtw89_phy_table_iter_init(&iter, table);
+	while ((reg = rtw89_phy_headline_next(&iter, *headline_size))) {
 		rfe_para = get_phy_cond_rfe(reg->addr);
 		cv_para = get_phy_cond_cv(reg->addr);
 		if (rfe_para == rfe) {
 			if (cv_para >= cv_max) {
 				cv_max = cv_para;
-				*headline_idx = i;
+				*headline_addr = reg->addr;
 				case_matched = true;
 			}
 		}
@@ -787,14 +975,14 @@ static int rtw89_phy_sel_headline(struct rtw89_dev *rtwdev,
 		return 0;
 
 	/* case 4: RFE don't care, CV max in table */
-	for (i = 0; i < *headline_size; i++) {
-		reg = &table->regs[i];
+	rtw89_phy_table_iter_init(&iter, table);
+	while ((reg = rtw89_phy_headline_next(&iter, *headline_size))) {
 		rfe_para = get_phy_cond_rfe(reg->addr);
 		cv_para = get_phy_cond_cv(reg->addr);
 		if (rfe_para == PHY_COND_DONT_CARE) {
 			if (cv_para >= cv_max) {
 				cv_max = cv_para;
-				*headline_idx = i;
+				*headline_addr = reg->addr;
 				case_matched = true;
 			}
 		}
@@ -806,20 +994,20 @@ static int rtw89_phy_sel_headline(struct rtw89_dev *rtwdev,
 	return -EINVAL;
 }
 
-static void rtw89_phy_init_reg(struct rtw89_dev *rtwdev,
-			       const struct rtw89_phy_table *table,
-			       void (*config)(struct rtw89_dev *rtwdev,
-					      const struct rtw89_reg2_def *reg,
-					      enum rtw89_rf_path rf_path,
-					      void *data),
-			       void *extra_data)
+static int rtw89_phy_walk_reg(struct rtw89_dev *rtwdev,
+			      const struct rtw89_phy_table *table,
+			      void (*config)(struct rtw89_dev *rtwdev,
+					     const struct rtw89_reg2_def *reg,
+					     enum rtw89_rf_path rf_path,
+					     void *data),
+			      void *extra_data)
 {
 	const struct rtw89_reg2_def *reg;
+	struct rtw89_phy_table_iter iter;
 	enum rtw89_rf_path rf_path = table->rf_path;
 	u8 rfe = rtwdev->efuse.rfe_type;
 	u8 cv = rtwdev->hal.cv;
-	u32 i;
-	u32 headline_size = 0, headline_idx = 0;
+	u32 headline_size = 0, headline_addr = 0;
 	u32 target = 0, cfg_target;
 	u8 cond;
 	bool is_matched = true;
@@ -827,15 +1015,17 @@ static void rtw89_phy_init_reg(struct rtw89_dev *rtwdev,
 	int ret;
 
 	ret = rtw89_phy_sel_headline(rtwdev, table, &headline_size,
-				     &headline_idx, rfe, cv);
+				     &headline_addr, rfe, cv);
 	if (ret) {
 		rtw89_err(rtwdev, "invalid PHY package: %d/%d\n", rfe, cv);
-		return;
+		return ret;
 	}
 
-	cfg_target = get_phy_target(table->regs[headline_idx].addr);
-	for (i = headline_size; i < table->n_regs; i++) {
-		reg = &table->regs[i];
+	cfg_target = get_phy_target(headline_addr);
+	rtw89_phy_table_iter_init(&iter, table);
+	while (rtw89_phy_headline_next(&iter, headline_size))
+		;
+	while ((reg = rtw89_phy_table_next(&iter))) {
 		cond = get_phy_cond(reg->addr);
 		switch (cond) {
 		case PHY_COND_BRANCH_IF:
@@ -847,7 +1037,7 @@ static void rtw89_phy_init_reg(struct rtw89_dev *rtwdev,
 			if (!target_found) {
 				rtw89_warn(rtwdev, "failed to load CR %x/%x\n",
 					   reg->addr, reg->data);
-				return;
+				return -EINVAL;
 			}
 			break;
 		case PHY_COND_BRANCH_END:
@@ -874,14 +1064,444 @@ static void rtw89_phy_init_reg(struct rtw89_dev *rtwdev,
 			break;
 		}
 	}
+
+	if (iter.err) {
+		rtw89_err(rtwdev, "malformed PHY table at entry %u\n", iter.idx);
+		return iter.err;
+	}
+
+	return 0;
 }
 
-void rtw89_phy_init_bb_reg(struct rtw89_dev *rtwdev)
+static void rtw89_phy_collect_reg(struct rtw89_dev *rtwdev,
+				  const struct rtw89_reg2_def *reg,
+				  enum rtw89_rf_path rf_path,
+				  void *extra_data)
+{
+	struct rtw89_phy_flat_table *flat = extra_data;
+
+	if (flat->regs)
+		flat->regs[flat->n_regs] = *reg;
+	flat->n_regs++;
+}
+
+/* Drop writes that repeat the entry right before them. This assumes the
+ * registers of the BB table are plain configuration registers, which hold
+ * the same state after the second identical write; write-triggered
+ * registers such as strobes or FIFO ports would not, so the NCTL and RF
+ * tables are not deduplicated. Delay markers are entries of their own and
+ * are never dropped, so nothing is merged across a delay; branches are
+ * already resolved at this point.
+ */
+static void rtw89_phy_dedup_table(struct rtw89_phy_flat_table *flat)
+{
+	struct rtw89_reg2_def *regs = flat->regs;
+	u32 i, n = 0;
+
+	for (i = 0; i < flat->n_regs; i++) {
+		if (n && !rtw89_phy_is_table_delay(regs[i].addr) &&
+		    regs[n - 1].addr == regs[i].addr &&
+		    regs[n - 1].data == regs[i].data)
+			continue;
+
+		regs[n++] = regs[i];
+	}
+
+	flat->n_dropped = flat->n_regs - n;
+	flat->n_regs = n;
+}
+
+static int rtw89_phy_flatten_table(struct rtw89_dev *rtwdev,
+				   const struct rtw89_phy_table *table,
+				   struct rtw89_phy_flat_table *flat)
+{
+	struct rtw89_reg2_def *regs;
+	ktime_t start;
+	u32 n_regs;
+	int ret;
+
+	memset(flat, 0, sizeof(*flat));
+
+	/* first walk sizes the table and costs what each init used to */
+	start = ktime_get();
+	ret = rtw89_phy_walk_reg(rtwdev, table, rtw89_phy_collect_reg, flat);
+	if (ret)
+		return ret;
+	flat->walk_us = ktime_us_delta(ktime_get(), start);
+
+	n_regs = flat->n_regs;
+	regs = kvmalloc_array(n_regs, sizeof(*regs), GFP_KERNEL);
+	if (!regs)
+		return -ENOMEM;
+
+	flat->regs = regs;
+	flat->n_regs = 0;
+	rtw89_phy_walk_reg(rtwdev, table, rtw89_phy_collect_reg, flat);
+	flat->n_src = rtw89_phy_table_size(table);
+
+	return 0;
+}
+
+static void rtw89_phy_init_reg(struct rtw89_dev *rtwdev,
+			       const struct rtw89_phy_table *table,
+			       struct rtw89_phy_flat_table *flat,
+			       void (*config)(struct rtw89_dev *rtwdev,
+					      const struct rtw89_reg2_def *reg,
+					      enum rtw89_rf_path rf_path,
+					      void *data),
+			       void *extra_data)
+{
+	struct rtw89_phy_flat_tables *tables = &rtwdev->phy_flat;
+	enum rtw89_rf_path rf_path = table->rf_path;
+	ktime_t start = ktime_get();
+	bool tagged;
+	u32 i;
+
+	tables->sleep_ns = 0;
+
+	/* profile the replay as part of the init step, not the config helpers */
+	tagged = rtw89_mmio_prof_tag(rtwdev, _RET_IP_);
+	if (flat->regs) {
+		for (i = 0; i < flat->n_regs; i++)
+			config(rtwdev, &flat->regs[i], rf_path, extra_data);
+	} else {
+		rtw89_phy_walk_reg(rtwdev, table, config, extra_data);
+	}
+	rtw89_mmio_prof_untag(rtwdev, tagged);
+
+	/* the rest of the wall time is spent on the CPU: writes and spins */
+	flat->replay_cnt++;
+	flat->replay_us = ktime_us_delta(ktime_get(), start);
+	flat->sleep_us = div_u64(tables->sleep_ns, NSEC_PER_USEC);
+	flat->cpu_us = flat->replay_us - min(flat->sleep_us, flat->replay_us);
+
+	rtw89_debug(rtwdev, RTW89_DBG_PHY_TRACK,
+		    "phy table path %d replay: wall %u us, cpu %u us, sleep %u us\n",
+		    rf_path, flat->replay_us, flat->cpu_us, flat->sleep_us);
+}
+
+static const struct rtw89_phy_table *
+rtw89_phy_get_table(struct rtw89_dev *rtwdev, enum rtw89_tbl_blob_id id)
+{
+	const struct rtw89_chip_info *chip = rtwdev->chip;
+	struct rtw89_phy_tbl_blob *blob = &rtwdev->tbl_blob;
+
+	if (blob->phy[id].packed)
+		return &blob->phy[id];
+
+	switch (id) {
+	case RTW89_TBL_BB:
+		return chip->bb_table;
+	case RTW89_TBL_NCTL:
+		return chip->nctl_table;
+	default:
+		return chip->rf_table[id - RTW89_TBL_RF_A];
+	}
+}
+
+static const struct rtw89_txpwr_lmt_dict *
+rtw89_phy_get_lmt(struct rtw89_dev *rtwdev, enum rtw89_tbl_blob_id id)
 {
 	const struct rtw89_chip_info *chip = rtwdev->chip;
-	const struct rtw89_phy_table *bb_table = chip->bb_table;
+	struct rtw89_phy_tbl_blob *blob = &rtwdev->tbl_blob;
+
+	if (blob->lmt[id - RTW89_TBL_LMT_2G].rows)
+		return &blob->lmt[id - RTW89_TBL_LMT_2G];
+
+	switch (id) {
+	case RTW89_TBL_LMT_2G:
+		return chip->txpwr_lmt_2g;
+	case RTW89_TBL_LMT_5G:
+		return chip->txpwr_lmt_5g;
+	case RTW89_TBL_LMT_RU_2G:
+		return chip->txpwr_lmt_ru_2g;
+	default:
+		return chip->txpwr_lmt_ru_5g;
+	}
+}
+
+static void rtw89_phy_tbl_blob_lmt_size(enum rtw89_tbl_blob_id id,
+					u8 *ch_num, u32 *n_rows)
+{
+	switch (id) {
+	case RTW89_TBL_LMT_2G:
+		*ch_num = RTW89_2G_CH_NUM;
+		*n_rows = RTW89_2G_BW_NUM * RTW89_NTX_NUM * RTW89_RS_LMT_NUM *
+			  RTW89_BF_NUM;
+		break;
+	case RTW89_TBL_LMT_5G:
+		*ch_num = RTW89_5G_CH_NUM;
+		*n_rows = RTW89_5G_BW_NUM * RTW89_NTX_NUM * RTW89_RS_LMT_NUM *
+			  RTW89_BF_NUM;
+		break;
+	case RTW89_TBL_LMT_RU_2G:
+		*ch_num = RTW89_2G_CH_NUM;
+		*n_rows = RTW89_RU_NUM * RTW89_NTX_NUM;
+		break;
+	default:
+		*ch_num = RTW89_5G_CH_NUM;
+		*n_rows = RTW89_RU_NUM * RTW89_NTX_NUM;
+		break;
+	}
+
+	*n_rows *= RTW89_REGD_NUM;
+}
+
+static int rtw89_phy_tbl_blob_check(const struct rtw89_tbl_blob_ent *ent,
+				    const u8 *data, size_t size)
+{
+	u32 n_items = le32_to_cpu(ent->n_items);
+	u32 off = le32_to_cpu(ent->off);
+	u32 len = le32_to_cpu(ent->len);
+	u32 pool_rows, i;
+	u32 n_rows;
+	u8 ch_num;
+
+	if (ent->id >= RTW89_TBL_NUM || off > size || len > size - off ||
+	    !IS_ALIGNED(off, sizeof(__le32)))
+		return -EINVAL;
+
+	if (ent->id < RTW89_TBL_PHY_NUM) {
+		if (!ent->arg || !n_items ||
+		    len < ent->n_conds * sizeof(struct rtw89_reg2_def))
+			return -EINVAL;
+
+		/* the stream itself is checked while it is decoded */
+		return 0;
+	}
+
+	rtw89_phy_tbl_blob_lmt_size(ent->id, &ch_num, &n_rows);
+	if (ent->arg != ch_num || n_items != n_rows || len <= n_items ||
+	    (len - n_items) % ch_num)
+		return -EINVAL;
+
+	/* rows are indexed without checks at lookup time */
+	pool_rows = (len - n_items) / ch_num;
+	for (i = 0; i < n_rows; i++)
+		if (data[off + i] >= pool_rows)
+			return -EINVAL;
+
+	return 0;
+}
+
+static int rtw89_phy_tbl_blob_parse(struct rtw89_dev *rtwdev,
+				    const struct firmware *firmware)
+{
+	struct rtw89_phy_tbl_blob *blob = &rtwdev->tbl_blob;
+	const struct rtw89_tbl_blob_hdr *hdr;
+	const struct rtw89_tbl_blob_ent *ent;
+	const u8 *data = firmware->data;
+	size_t size = firmware->size;
+	struct rtw89_phy_packed_table *packed;
+	struct rtw89_txpwr_lmt_dict *dict;
+	struct rtw89_reg2_def *cond;
+	const __le32 *raw;
+	u32 n_ent, n_conds = 0, seen = 0;
+	u32 off, len, i, j;
+	int ret;
+
+	if (size < sizeof(*hdr))
+		return -EINVAL;
+
+	hdr = (const struct rtw89_tbl_blob_hdr *)data;
+	if (le32_to_cpu(hdr->magic) != RTW89_TBL_BLOB_MAGIC ||
+	    hdr->format != RTW89_TBL_BLOB_FORMAT ||
+	    hdr->chip_id != rtwdev->chip->chip_id ||
+	    le32_to_cpu(hdr->len) != size)
+		return -EINVAL;
+
+	if (~crc32_le(~0, data + sizeof(*hdr), size - sizeof(*hdr)) !=
+	    le32_to_cpu(hdr->crc))
+		return -EBADMSG;
+
+	n_ent = le16_to_cpu(hdr->n_ent);
+	if (n_ent > (size - sizeof(*hdr)) / sizeof(*ent))
+		return -EINVAL;
 
-	rtw89_phy_init_reg(rtwdev, bb_table, rtw89_phy_config_bb_reg, NULL);
+	/* check every entry before any of them replaces a built-in table */
+	ent = (const struct rtw89_tbl_blob_ent *)(hdr + 1);
+	for (i = 0; i < n_ent; i++) {
+		ret = rtw89_phy_tbl_blob_check(&ent[i], data, size);
+		if (ret)
+			return ret;
+		if (seen & BIT(ent[i].id))
+			return -EINVAL;
+
+		seen |= BIT(ent[i].id);
+		if (ent[i].id < RTW89_TBL_PHY_NUM)
+			n_conds += ent[i].n_conds;
+	}
+
+	cond = kcalloc(n_conds, sizeof(*cond), GFP_KERNEL);
+	if (!cond)
+		return -ENOMEM;
+
+	blob->conds = cond;
+	blob->version = le32_to_cpu(hdr->version);
+
+	for (i = 0; i < n_ent; i++) {
+		off = le32_to_cpu(ent[i].off);
+		len = le32_to_cpu(ent[i].len);
+
+		if (ent[i].id >= RTW89_TBL_PHY_NUM) {
+			dict = &blob->lmt[ent[i].id - RTW89_TBL_LMT_2G];
+			dict->rows = data + off;
+			dict->pool = (const s8 *)data + off +
+				     le32_to_cpu(ent[i].n_items);
+			dict->ch_num = ent[i].arg;
+			continue;
+		}
+
+		packed = &blob->packed[ent[i].id];
+		raw = (const __le32 *)(data + off);
+		for (j = 0; j < ent[i].n_conds; j++) {
+			cond[j].addr = le32_to_cpu(raw[j * 2]);
+			cond[j].data = le32_to_cpu(raw[j * 2 + 1]);
+		}
+
+		packed->conds = cond;
+		packed->n_conds = ent[i].n_conds;
+		packed->data = data + off + j * sizeof(*cond);
+		packed->len = len - j * sizeof(*cond);
+		packed->n_regs = le32_to_cpu(ent[i].n_items);
+		packed->stride = ent[i].arg;
+		cond += j;
+
+		blob->phy[ent[i].id].packed = packed;
+		if (ent[i].id >= RTW89_TBL_RF_A)
+			blob->phy[ent[i].id].rf_path = ent[i].id - RTW89_TBL_RF_A;
+	}
+
+	return 0;
+}
+
+static void rtw89_phy_tbl_blob_free(struct rtw89_dev *rtwdev)
+{
+	struct rtw89_phy_tbl_blob *blob = &rtwdev->tbl_blob;
+
+	kfree(blob->conds);
+	release_firmware(blob->firmware);
+	memset(blob, 0, sizeof(*blob));
+}
+
+/* The blob is optional: without one, or with one that does not check out,
+ * the compiled-in tables are used. Register streams are only decoded while
+ * they are flattened below, and limits are read from the blob in place.
+ */
+static void rtw89_phy_tbl_blob_load(struct rtw89_dev *rtwdev)
+{
+	struct rtw89_phy_tbl_blob *blob = &rtwdev->tbl_blob;
+	const char *name = rtwdev->chip->table_name;
+	const struct firmware *firmware;
+	ktime_t start = ktime_get();
+	int ret;
+
+	if (!name)
+		return;
+
+	ret = request_firmware_direct(&firmware, name, rtwdev->dev);
+	if (ret) {
+		rtw89_debug(rtwdev, RTW89_DBG_FW, "no table blob %s: %d\n",
+			    name, ret);
+		return;
+	}
+
+	blob->firmware = firmware;
+	ret = rtw89_phy_tbl_blob_parse(rtwdev, firmware);
+	if (ret) {
+		rtw89_warn(rtwdev, "invalid table blob %s: %d, using built-in tables\n",
+			   name, ret);
+		rtw89_phy_tbl_blob_free(rtwdev);
+		return;
+	}
+
+	blob->load_us = ktime_us_delta(ktime_get(), start);
+	rtw89_info(rtwdev, "loaded tables version %u from %s in %u us\n",
+		   blob->version, name, blob->load_us);
+}
+
+static int rtw89_phy_setup_table(struct rtw89_dev *rtwdev,
+				 enum rtw89_tbl_blob_id id,
+				 struct rtw89_phy_flat_table *flat)
+{
+	struct rtw89_phy_tbl_blob *blob = &rtwdev->tbl_blob;
+	const struct rtw89_phy_table *table = rtw89_phy_get_table(rtwdev, id);
+	int ret;
+
+	ret = rtw89_phy_flatten_table(rtwdev, table, flat);
+	if (!ret || table != &blob->phy[id])
+		return ret;
+
+	/* never walk a broken table from the blob at init time */
+	rtw89_warn(rtwdev, "table %d of %s is unusable, using built-in one\n",
+		   id, rtwdev->chip->table_name);
+	blob->phy[id].packed = NULL;
+
+	return rtw89_phy_flatten_table(rtwdev, rtw89_phy_get_table(rtwdev, id),
+				       flat);
+}
+
+static void rtw89_phy_tables_report(struct rtw89_dev *rtwdev,
+				    const char *name,
+				    struct rtw89_phy_flat_table *flat)
+{
+	rtw89_debug(rtwdev, RTW89_DBG_PHY_TRACK,
+		    "%s table: %u of %u entries kept, %u us and %u writes saved per init\n",
+		    name, flat->n_regs, flat->n_src, flat->walk_us,
+		    flat->n_dropped);
+}
+
+/* Resolve the RFE/CV conditions of the PHY tables once, so that every
+ * power-on only replays a flat list of writes and delays. Tables that fail
+ * to flatten are walked at init time as before.
+ */
+void rtw89_phy_tables_setup(struct rtw89_dev *rtwdev)
+{
+	const struct rtw89_chip_info *chip = rtwdev->chip;
+	struct rtw89_phy_flat_tables *tables = &rtwdev->phy_flat;
+	u8 path;
+
+	rtw89_phy_tbl_blob_load(rtwdev);
+
+	if (!rtw89_phy_setup_table(rtwdev, RTW89_TBL_BB, &tables->bb)) {
+		rtw89_phy_dedup_table(&tables->bb);
+		rtw89_phy_tables_report(rtwdev, "bb", &tables->bb);
+	}
+
+	for (path = RF_PATH_A; path < chip->rf_path_num; path++)
+		if (!rtw89_phy_setup_table(rtwdev, RTW89_TBL_RF_A + path,
+					   &tables->rf[path]))
+			rtw89_phy_tables_report(rtwdev, "rf", &tables->rf[path]);
+
+	if (!rtw89_phy_setup_table(rtwdev, RTW89_TBL_NCTL, &tables->nctl))
+		rtw89_phy_tables_report(rtwdev, "nctl", &tables->nctl);
+}
+
+void rtw89_phy_tables_free(struct rtw89_dev *rtwdev)
+{
+	struct rtw89_phy_flat_tables *tables = &rtwdev->phy_flat;
+	u8 path;
+
+	kvfree(tables->bb.regs);
+	tables->bb.regs = NULL;
+	for (path = RF_PATH_A; path < RF_PATH_MAX; path++) {
+		kvfree(tables->rf[path].regs);
+		tables->rf[path].regs = NULL;
+	}
+	kvfree(tables->nctl.regs);
+	tables->nctl.regs = NULL;
+
+	rtw89_phy_tbl_blob_free(rtwdev);
+}
+
+void rtw89_phy_init_bb_reg(struct rtw89_dev *rtwdev)
+{
+	const struct rtw89_phy_table *bb_table;
+
+	bb_table = rtw89_phy_get_table(rtwdev, RTW89_TBL_BB);
+
+	rtw89_phy_init_reg(rtwdev, bb_table, &rtwdev->phy_flat.bb,
+			   rtw89_phy_config_bb_reg, NULL);
 	rtw89_chip_init_txpwr_unit(rtwdev, RTW89_PHY_0);
 	rtw89_phy_bb_reset(rtwdev, RTW89_PHY_0);
 }
@@ -906,9 +1526,9 @@ void rtw89_phy_init_rf_reg(struct rtw89_dev *rtwdev)
 
 	for (path = RF_PATH_A; path < chip->rf_path_num; path++) {
 		rf_reg_info->rf_path = path;
-		rf_table = chip->rf_table[path];
-		rtw89_phy_init_reg(rtwdev, rf_table, rtw89_phy_config_rf_reg,
-				   (void *)rf_reg_info);
+		rf_table = rtw89_phy_get_table(rtwdev, RTW89_TBL_RF_A + path);
+		rtw89_phy_init_reg(rtwdev, rf_table, &rtwdev->phy_flat.rf[path],
+				   rtw89_phy_config_rf_reg, (void *)rf_reg_info);
 		if (rtw89_phy_config_rf_reg_fw(rtwdev, rf_reg_info))
 			rtw89_warn(rtwdev, "rf path %d reg h2c config failed\n",
 				   path);
@@ -918,7 +1538,6 @@ void rtw89_phy_init_rf_reg(struct rtw89_dev *rtwdev)
 
 static void rtw89_phy_init_rf_nctl(struct rtw89_dev *rtwdev)
 {
-	const struct rtw89_chip_info *chip = rtwdev->chip;
 	const struct rtw89_phy_table *nctl_table;
 	u32 val;
 	int ret;
@@ -937,8 +1556,9 @@ static void rtw89_phy_init_rf_nctl(struct rtw89_dev *rtwdev)
 	if (ret)
 		rtw89_err(rtwdev, "failed to poll nctl block\n");
 
-	nctl_table = chip->nctl_table;
-	rtw89_phy_init_reg(rtwdev, nctl_table, rtw89_phy_config_bb_reg, NULL);
+	nctl_table = rtw89_phy_get_table(rtwdev, RTW89_TBL_NCTL);
+	rtw89_phy_init_reg(rtwdev, nctl_table, &rtwdev->phy_flat.nctl,
+			   rtw89_phy_config_bb_reg, NULL);
 }
 
 static u32 rtw89_phy0_phy1_offset(struct rtw89_dev *rtwdev, u32 addr)
@@ -995,12 +1615,16 @@ void rtw89_phy_write_reg3_tbl(struct rtw89_dev *rtwdev,
 			      const struct rtw89_phy_reg3_tbl *tbl)
 {
 	const struct rtw89_reg3_def *reg3;
+	struct rtw89_reg_batch batch = {};
 	int i;
 
 	for (i = 0; i < tbl->size; i++) {
 		reg3 = &tbl->reg3[i];
-		rtw89_phy_write32_mask(rtwdev, reg3->addr, reg3->mask, reg3->data);
+		rtw89_reg_batch_write32_mask(rtwdev, &batch,
+					     reg3->addr | RTW89_PHY_ADDR_OFFSET,
+					     reg3->mask, reg3->data);
 	}
+	rtw89_reg_batch_flush(rtwdev, &batch);
 }
 
 const u8 rtw89_rs_idx_max[] = {
@@ -1099,31 +1723,52 @@ static u8 rtw89_channel_to_idx(struct rtw89_dev *rtwdev, u8 channel)
 	}
 }
 
+static s8 rtw89_phy_lmt_dict_get(const struct rtw89_txpwr_lmt_dict *dict,
+				 u32 row, u8 regd, u8 ch_idx)
+{
+	u8 pool_row = dict->rows[row * RTW89_REGD_NUM + regd];
+
+	return dict->pool[pool_row * dict->ch_num + ch_idx];
+}
+
+/* fall back to the worldwide limit where the regulation has none */
+static s8 rtw89_phy_lmt_dict_read(struct rtw89_dev *rtwdev,
+				  enum rtw89_tbl_blob_id id,
+				  u32 row, u8 regd, u8 ch_idx)
+{
+	const struct rtw89_txpwr_lmt_dict *dict = rtw89_phy_get_lmt(rtwdev, id);
+	s8 lmt = rtw89_phy_lmt_dict_get(dict, row, regd, ch_idx);
+
+	if (!lmt)
+		lmt = rtw89_phy_lmt_dict_get(dict, row, RTW89_WW, ch_idx);
+
+	return lmt;
+}
+
 s8 rtw89_phy_read_txpwr_limit(struct rtw89_dev *rtwdev,
 			      u8 bw, u8 ntx, u8 rs, u8 bf, u8 ch)
 {
-	const struct rtw89_chip_info *chip = rtwdev->chip;
 	u8 ch_idx = rtw89_channel_to_idx(rtwdev, ch);
 	u8 band = rtwdev->hal.current_band_type;
 	u8 regd = rtw89_regd_get(rtwdev, band);
+	u32 row;
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 11, 0)
 	s8 lmt = 0, sar;
 #else
 	s8 lmt = 0;
 #endif
 
+	row = ((bw * RTW89_NTX_NUM + ntx) * RTW89_RS_LMT_NUM + rs) *
+	      RTW89_BF_NUM + bf;
+
 	switch (band) {
 	case RTW89_BAND_2G:
-		lmt = (*chip->txpwr_lmt_2g)[bw][ntx][rs][bf][regd][ch_idx];
-		if (!lmt)
-			lmt = (*chip->txpwr_lmt_2g)[bw][ntx][rs][bf]
-						   [RTW89_WW][ch_idx];
+		lmt = rtw89_phy_lmt_dict_read(rtwdev, RTW89_TBL_LMT_2G, row,
+					      regd, ch_idx);
 		break;
 	case RTW89_BAND_5G:
-		lmt = (*chip->txpwr_lmt_5g)[bw][ntx][rs][bf][regd][ch_idx];
-		if (!lmt)
-			lmt = (*chip->txpwr_lmt_5g)[bw][ntx][rs][bf]
-						   [RTW89_WW][ch_idx];
+		lmt = rtw89_phy_lmt_dict_read(rtwdev, RTW89_TBL_LMT_5G, row,
+					      regd, ch_idx);
 		break;
 	default:
 		rtw89_warn(rtwdev, "unknown band type: %d\n", band);
@@ -1241,28 +1886,26 @@ void rtw89_phy_fill_txpwr_limit(struct rtw89_dev *rtwdev,
 static s8 rtw89_phy_read_txpwr_limit_ru(struct rtw89_dev *rtwdev,
 					u8 ru, u8 ntx, u8 ch)
 {
-	const struct rtw89_chip_info *chip = rtwdev->chip;
 	u8 ch_idx = rtw89_channel_to_idx(rtwdev, ch);
 	u8 band = rtwdev->hal.current_band_type;
 	u8 regd = rtw89_regd_get(rtwdev, band);
+	u32 row;
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 11, 0)
 	s8 lmt_ru = 0, sar;
 #else
 	s8 lmt_ru = 0;
 #endif
 
+	row = ru * RTW89_NTX_NUM + ntx;
+
 	switch (band) {
 	case RTW89_BAND_2G:
-		lmt_ru = (*chip->txpwr_lmt_ru_2g)[ru][ntx][regd][ch_idx];
-		if (!lmt_ru)
-			lmt_ru = (*chip->txpwr_lmt_ru_2g)[ru][ntx]
-							 [RTW89_WW][ch_idx];
+		lmt_ru = rtw89_phy_lmt_dict_read(rtwdev, RTW89_TBL_LMT_RU_2G,
+						 row, regd, ch_idx);
 		break;
 	case RTW89_BAND_5G:
-		lmt_ru = (*chip->txpwr_lmt_ru_5g)[ru][ntx][regd][ch_idx];
-		if (!lmt_ru)
-			lmt_ru = (*chip->txpwr_lmt_ru_5g)[ru][ntx]
-							 [RTW89_WW][ch_idx];
+		lmt_ru = rtw89_phy_lmt_dict_read(rtwdev, RTW89_TBL_LMT_RU_5G,
+						 row, regd, ch_idx);
 		break;
 	default:
 		rtw89_warn(rtwdev, "unknown band type: %d\n", band);
@@ -1364,6 +2007,57 @@ void rtw89_phy_fill_txpwr_limit_ru(struct rtw89_dev *rtwdev,
 	}
 }
 
+const struct rtw89_txpwr_lmt_rec *
+rtw89_phy_get_txpwr_lmt_rec(struct rtw89_dev *rtwdev)
+{
+	struct rtw89_txpwr_lmt_cache *cache = &rtwdev->txpwr_lmt_cache;
+	u8 band = rtwdev->hal.current_band_type;
+	u8 ch = rtwdev->hal.current_channel;
+	u8 bw = rtwdev->hal.current_band_width;
+	struct rtw89_txpwr_lmt_rec *rec;
+	u8 i;
+
+	lockdep_assert_held(&rtwdev->mutex);
+
+	for (i = 0; i < RTW89_TXPWR_LMT_CACHE_NUM; i++) {
+		rec = &cache->recs[i];
+		if (rec->valid && rec->band == band && rec->ch == ch &&
+		    rec->bw == bw) {
+			cache->hit++;
+			return rec;
+		}
+	}
+
+	rec = &cache->recs[cache->next];
+	cache->next = (cache->next + 1) % RTW89_TXPWR_LMT_CACHE_NUM;
+	cache->miss++;
+
+	for (i = 0; i < RTW89_NTX_NUM; i++) {
+		rtw89_phy_fill_txpwr_limit(rtwdev, &rec->lmt[i], i);
+		rtw89_phy_fill_txpwr_limit_ru(rtwdev, &rec->lmt_ru[i], i);
+	}
+	rec->band = band;
+	rec->ch = ch;
+	rec->bw = bw;
+	rec->valid = true;
+
+	rtw89_debug(rtwdev, RTW89_DBG_TXPWR,
+		    "[TXPWR] cache limits of ch=%d bw=%d (hit %u miss %u)\n",
+		    ch, bw, cache->hit, cache->miss);
+
+	return rec;
+}
+
+/* limits depend on the regulatory domain and SAR, drop them on changes */
+void rtw89_phy_txpwr_lmt_invalidate(struct rtw89_dev *rtwdev)
+{
+	struct rtw89_txpwr_lmt_cache *cache = &rtwdev->txpwr_lmt_cache;
+	u8 i;
+
+	for (i = 0; i < RTW89_TXPWR_LMT_CACHE_NUM; i++)
+		cache->recs[i].valid = false;
+}
+
 struct rtw89_phy_iter_ra_data {
 	struct rtw89_dev *rtwdev;
 	struct sk_buff *c2h;
@@ -1458,6 +2152,15 @@ void (* const rtw89_phy_c2h_ra_handler[])(struct rtw89_dev *rtwdev,
 	[RTW89_PHY_C2H_FUNC_TXSTS] = NULL,
 };
 
+/* RA reports are applied through the atomic station iterator and don't need
+ * rtwdev->mutex
+ */
+bool rtw89_phy_c2h_chk_atomic(u8 class, u8 func)
+{
+	return class == RTW89_PHY_C2H_CLASS_RA &&
+	       func == RTW89_PHY_C2H_FUNC_STS_RPT;
+}
+
 void rtw89_phy_c2h_handle(struct rtw89_dev *rtwdev, struct sk_buff *skb,
 			  u32 len, u8 class, u8 func)
 {
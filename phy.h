@@ -27,6 +27,47 @@
 #define PHY_COND_CHECK		0x4
 #define PHY_COND_DONT_CARE	0xff
 
+/* tag byte of a packed table entry, see table_pack.py */
+#define RTW89_PHY_PACK_COND		0xc0
+#define RTW89_PHY_PACK_ADDR		GENMASK(7, 6)
+#define RTW89_PHY_PACK_ADDR_SAME	0
+#define RTW89_PHY_PACK_ADDR_NEXT	1
+#define RTW89_PHY_PACK_ADDR_DELTA	2
+#define RTW89_PHY_PACK_DATA		GENMASK(5, 0)
+#define RTW89_PHY_PACK_DATA_LIT_MAX	0x3a
+#define RTW89_PHY_PACK_DATA_PREV	0x3f
+
+/* Table blob, made by "table_pack.py blob". All fields are little endian;
+ * the header is followed by n_ent entries and their data. A register table
+ * is n_conds {addr, data} pairs and the packed stream; a limit table is one
+ * u8 pool index per row and the pool of channel rows.
+ */
+#define RTW89_TBL_BLOB_MAGIC	0x54393852 /* "R89T" */
+#define RTW89_TBL_BLOB_FORMAT	1
+
+struct rtw89_tbl_blob_hdr {
+	__le32 magic;
+	u8 format;
+	u8 chip_id;
+	__le16 n_ent;
+	__le32 version;
+	__le32 len;
+	/* crc32 of everything after the header */
+	__le32 crc;
+} __packed;
+
+struct rtw89_tbl_blob_ent {
+	u8 id;
+	/* stride of a register table, channel count of a limit table */
+	u8 arg;
+	u8 n_conds;
+	u8 rsvd;
+	/* entries of a register table, rows of a limit table */
+	__le32 n_items;
+	__le32 off;
+	__le32 len;
+} __packed;
+
 #define RA_MASK_CCK_RATES	GENMASK_ULL(3, 0)
 #define RA_MASK_OFDM_RATES	GENMASK_ULL(11, 4)
 #define RA_MASK_SUBCCK_RATES	0x5ULL
@@ -268,59 +309,59 @@ const struct rtw89_phy_reg3_tbl _name ## _tbl = {	\
 	.size = ARRAY_SIZE(_name),			\
 }
 
-static inline void rtw89_phy_write8(struct rtw89_dev *rtwdev,
-				    u32 addr, u8 data)
+static __always_inline void rtw89_phy_write8(struct rtw89_dev *rtwdev,
+					     u32 addr, u8 data)
 {
 	rtw89_write8(rtwdev, addr | RTW89_PHY_ADDR_OFFSET, data);
 }
 
-static inline void rtw89_phy_write16(struct rtw89_dev *rtwdev,
-				     u32 addr, u16 data)
+static __always_inline void rtw89_phy_write16(struct rtw89_dev *rtwdev,
+					      u32 addr, u16 data)
 {
 	rtw89_write16(rtwdev, addr | RTW89_PHY_ADDR_OFFSET, data);
 }
 
-static inline void rtw89_phy_write32(struct rtw89_dev *rtwdev,
-				     u32 addr, u32 data)
+static __always_inline void rtw89_phy_write32(struct rtw89_dev *rtwdev,
+					      u32 addr, u32 data)
 {
 	rtw89_write32(rtwdev, addr | RTW89_PHY_ADDR_OFFSET, data);
 }
 
-static inline void rtw89_phy_write32_set(struct rtw89_dev *rtwdev,
-					 u32 addr, u32 bits)
+static __always_inline void rtw89_phy_write32_set(struct rtw89_dev *rtwdev,
+						  u32 addr, u32 bits)
 {
 	rtw89_write32_set(rtwdev, addr | RTW89_PHY_ADDR_OFFSET, bits);
 }
 
-static inline void rtw89_phy_write32_clr(struct rtw89_dev *rtwdev,
-					 u32 addr, u32 bits)
+static __always_inline void rtw89_phy_write32_clr(struct rtw89_dev *rtwdev,
+						  u32 addr, u32 bits)
 {
 	rtw89_write32_clr(rtwdev, addr | RTW89_PHY_ADDR_OFFSET, bits);
 }
 
-static inline void rtw89_phy_write32_mask(struct rtw89_dev *rtwdev,
-					  u32 addr, u32 mask, u32 data)
+static __always_inline void rtw89_phy_write32_mask(struct rtw89_dev *rtwdev,
+						   u32 addr, u32 mask, u32 data)
 {
 	rtw89_write32_mask(rtwdev, addr | RTW89_PHY_ADDR_OFFSET, mask, data);
 }
 
-static inline u8 rtw89_phy_read8(struct rtw89_dev *rtwdev, u32 addr)
+static __always_inline u8 rtw89_phy_read8(struct rtw89_dev *rtwdev, u32 addr)
 {
 	return rtw89_read8(rtwdev, addr | RTW89_PHY_ADDR_OFFSET);
 }
 
-static inline u16 rtw89_phy_read16(struct rtw89_dev *rtwdev, u32 addr)
+static __always_inline u16 rtw89_phy_read16(struct rtw89_dev *rtwdev, u32 addr)
 {
 	return rtw89_read16(rtwdev, addr | RTW89_PHY_ADDR_OFFSET);
 }
 
-static inline u32 rtw89_phy_read32(struct rtw89_dev *rtwdev, u32 addr)
+static __always_inline u32 rtw89_phy_read32(struct rtw89_dev *rtwdev, u32 addr)
 {
 	return rtw89_read32(rtwdev, addr | RTW89_PHY_ADDR_OFFSET);
 }
 
-static inline u32 rtw89_phy_read32_mask(struct rtw89_dev *rtwdev,
-					u32 addr, u32 mask)
+static __always_inline u32 rtw89_phy_read32_mask(struct rtw89_dev *rtwdev,
+						 u32 addr, u32 mask)
 {
 	return rtw89_read32_mask(rtwdev, addr | RTW89_PHY_ADDR_OFFSET, mask);
 }
@@ -334,6 +375,11 @@ u32 rtw89_phy_read_rf(struct rtw89_dev *rtwdev, enum rtw89_rf_path rf_path,
 		      u32 addr, u32 mask);
 bool rtw89_phy_write_rf(struct rtw89_dev *rtwdev, enum rtw89_rf_path rf_path,
 			u32 addr, u32 mask, u32 data);
+bool rtw89_phy_write_rf_nodelay(struct rtw89_dev *rtwdev,
+				enum rtw89_rf_path rf_path,
+				u32 addr, u32 mask, u32 data);
+void rtw89_phy_tables_setup(struct rtw89_dev *rtwdev);
+void rtw89_phy_tables_free(struct rtw89_dev *rtwdev);
 void rtw89_phy_init_bb_reg(struct rtw89_dev *rtwdev);
 void rtw89_phy_init_rf_reg(struct rtw89_dev *rtwdev);
 void rtw89_phy_dm_init(struct rtw89_dev *rtwdev);
@@ -349,6 +395,9 @@ void rtw89_phy_fill_txpwr_limit(struct rtw89_dev *rtwdev,
 void rtw89_phy_fill_txpwr_limit_ru(struct rtw89_dev *rtwdev,
 				   struct rtw89_txpwr_limit_ru *lmt_ru,
 				   u8 ntx);
+const struct rtw89_txpwr_lmt_rec *
+rtw89_phy_get_txpwr_lmt_rec(struct rtw89_dev *rtwdev);
+void rtw89_phy_txpwr_lmt_invalidate(struct rtw89_dev *rtwdev);
 s8 rtw89_phy_read_txpwr_limit(struct rtw89_dev *rtwdev,
 			      u8 bw, u8 ntx, u8 rs, u8 bf, u8 ch);
 void rtw89_phy_ra_assoc(struct rtw89_dev *rtwdev, struct ieee80211_sta *sta);
@@ -357,6 +406,7 @@ void rtw89_phy_ra_updata_sta(struct rtw89_dev *rtwdev, struct ieee80211_sta *sta
 void rtw89_phy_rate_pattern_vif(struct rtw89_dev *rtwdev,
 				struct ieee80211_vif *vif,
 				const struct cfg80211_bitrate_mask *mask);
+bool rtw89_phy_c2h_chk_atomic(u8 class, u8 func);
 void rtw89_phy_c2h_handle(struct rtw89_dev *rtwdev, struct sk_buff *skb,
 			  u32 len, u8 class, u8 func);
 void rtw89_phy_cfo_track(struct rtw89_dev *rtwdev);
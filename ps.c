@@ -11,6 +11,8 @@
 #include "reg.h"
 #include "util.h"
 
+#define RTW89_LPS_LEAVE_ACK_TIMEOUT 10 /* ms */
+
 static int rtw89_fw_leave_lps_check(struct rtw89_dev *rtwdev, u8 macid)
 {
 	u32 pwr_en_bit = 0xE;
@@ -68,9 +70,17 @@ static void __rtw89_leave_lps(struct rtw89_dev *rtwdev, u8 mac_id)
 		.psmode = RTW89_MAC_AX_PS_MODE_ACTIVE,
 		.lastrpwm = RTW89_LAST_RPWM_ACTIVE,
 	};
+	u8 seq = rtw89_fw_h2c_next_seq(rtwdev);
 
 	rtw89_fw_h2c_lps_parm(rtwdev, &lps_param);
+	/* sleep until firmware has handled it instead of spinning on the
+	 * power bits; the register check below stays authoritative
+	 */
+	rtw89_fw_h2c_wait_ack(rtwdev, seq, RTW89_H2C_ACK_DONE,
+			      RTW89_LPS_LEAVE_ACK_TIMEOUT, NULL);
 	rtw89_fw_leave_lps_check(rtwdev, 0);
+	/* baseband may have been power gated while in LPS */
+	rtw89_shadow_reset(rtwdev);
 	rtw89_btc_ntfy_radio_state(rtwdev, BTC_RFCTRL_WL_ON);
 }
 
@@ -3,6 +3,7 @@
  */
 
 #include "debug.h"
+#include "phy.h"
 #include "ps.h"
 
 #define COUNTRY_REGD(_alpha2, _txpwr_regd_2g, _txpwr_regd_5g) \
@@ -286,6 +287,7 @@ int rtw89_regd_init(struct rtw89_dev *rtwdev,
 	chip_regd = rtw89_regd_find_reg_by_name(rtwdev->efuse.country_code);
 	if (!rtw89_regd_is_ww(chip_regd)) {
 		rtwdev->regd = chip_regd;
+		rtw89_phy_txpwr_lmt_invalidate(rtwdev);
 		/* Ignore country ie if there is a country domain programmed in chip */
 		wiphy->regulatory_flags |= REGULATORY_COUNTRY_IE_IGNORE;
 		wiphy->regulatory_flags |= REGULATORY_STRICT_REG;
@@ -316,6 +318,7 @@ static void rtw89_regd_notifier_apply(struct rtw89_dev *rtwdev,
 				      struct regulatory_request *request)
 {
 	rtwdev->regd = rtw89_regd_find_reg_by_name(request->alpha2);
+	rtw89_phy_txpwr_lmt_invalidate(rtwdev);
 	/* This notification might be set from the system of distros,
 	 * and it does not expect the regulatory will be modified by
 	 * connecting to an AP (i.e. country ie).
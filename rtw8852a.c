@@ -50,6 +50,13 @@ static const struct rtw89_dle_mem rtw8852a_dle_mem_pcie[] = {
 			       NULL},
 };
 
+/* BB control registers; NCTL/RFK and RF direct access from 0x8000 up are
+ * also written by hardware and firmware, so they are left out.
+ */
+static const struct rtw89_reg_range rtw8852a_shadow_ranges[] = {
+	{RTW89_PHY_ADDR_OFFSET, RTW89_PHY_ADDR_OFFSET + 0x8000},
+};
+
 static const struct rtw89_reg2_def  rtw8852a_pmac_ht20_mcs7_tbl[] = {
 	{0x44AC, 0x00000000},
 	{0x44B0, 0x00000000},
@@ -1367,7 +1374,7 @@ static void rtw8852a_set_txpwr_limit(struct rtw89_dev *rtwdev,
 #define __MAC_TXPWR_LMT_PAGE_SIZE 40
 	u8 ch = rtwdev->hal.current_channel;
 	u8 bw = rtwdev->hal.current_band_width;
-	struct rtw89_txpwr_limit lmt[NTX_NUM_8852A];
+	const struct rtw89_txpwr_lmt_rec *rec;
 	u32 addr, val;
 	const s8 *ptr;
 	u8 i, j, k;
@@ -1375,12 +1382,12 @@ static void rtw8852a_set_txpwr_limit(struct rtw89_dev *rtwdev,
 	rtw89_debug(rtwdev, RTW89_DBG_TXPWR,
 		    "[TXPWR] set txpwr limit with ch=%d bw=%d\n", ch, bw);
 
-	for (i = 0; i < NTX_NUM_8852A; i++) {
-		rtw89_phy_fill_txpwr_limit(rtwdev, &lmt[i], i);
+	rec = rtw89_phy_get_txpwr_lmt_rec(rtwdev);
 
+	for (i = 0; i < NTX_NUM_8852A; i++) {
 		for (j = 0; j < __MAC_TXPWR_LMT_PAGE_SIZE; j += 4) {
 			addr = R_AX_PWR_LMT + j + __MAC_TXPWR_LMT_PAGE_SIZE * i;
-			ptr = (s8 *)&lmt[i] + j;
+			ptr = (s8 *)&rec->lmt[i] + j;
 			val = 0;
 
 			for (k = 0; k < 4; k++)
@@ -1398,7 +1405,7 @@ static void rtw8852a_set_txpwr_limit_ru(struct rtw89_dev *rtwdev,
 #define __MAC_TXPWR_LMT_RU_PAGE_SIZE 24
 	u8 ch = rtwdev->hal.current_channel;
 	u8 bw = rtwdev->hal.current_band_width;
-	struct rtw89_txpwr_limit_ru lmt_ru[NTX_NUM_8852A];
+	const struct rtw89_txpwr_lmt_rec *rec;
 	u32 addr, val;
 	const s8 *ptr;
 	u8 i, j, k;
@@ -1406,13 +1413,13 @@ static void rtw8852a_set_txpwr_limit_ru(struct rtw89_dev *rtwdev,
 	rtw89_debug(rtwdev, RTW89_DBG_TXPWR,
 		    "[TXPWR] set txpwr limit ru with ch=%d bw=%d\n", ch, bw);
 
-	for (i = 0; i < NTX_NUM_8852A; i++) {
-		rtw89_phy_fill_txpwr_limit_ru(rtwdev, &lmt_ru[i], i);
+	rec = rtw89_phy_get_txpwr_lmt_rec(rtwdev);
 
+	for (i = 0; i < NTX_NUM_8852A; i++) {
 		for (j = 0; j < __MAC_TXPWR_LMT_RU_PAGE_SIZE; j += 4) {
 			addr = R_AX_PWR_RU_LMT + j +
 			       __MAC_TXPWR_LMT_RU_PAGE_SIZE * i;
-			ptr = (s8 *)&lmt_ru[i] + j;
+			ptr = (s8 *)&rec->lmt_ru[i] + j;
 			val = 0;
 
 			for (k = 0; k < 4; k++)
@@ -1965,6 +1972,7 @@ static const struct rtw89_chip_ops rtw8852a_chip_ops = {
 	.bb_sethw		= rtw8852a_bb_sethw,
 	.read_rf		= rtw89_phy_read_rf,
 	.write_rf		= rtw89_phy_write_rf,
+	.write_rf_nodelay	= rtw89_phy_write_rf_nodelay,
 	.set_channel		= rtw8852a_set_channel,
 	.set_channel_help	= rtw8852a_set_channel_help,
 	.read_efuse		= rtw8852a_read_efuse,
@@ -1999,12 +2007,15 @@ const struct rtw89_chip_info rtw8852a_chip_info = {
 	.chip_id		= RTL8852A,
 	.ops			= &rtw8852a_chip_ops,
 	.fw_name		= "rtw89/rtw8852a_fw.bin",
+	.table_name		= "rtw89/rtw8852a_table.bin",
 	.fifo_size		= 458752,
 	.max_amsdu_limit	= 3500,
 	.dis_2g_40m_ul_ofdma	= true,
 	.hfc_param_ini		= rtw8852a_hfc_param_ini_pcie,
 	.dle_mem		= rtw8852a_dle_mem_pcie,
 	.rf_base_addr		= {0xc000, 0xd000},
+	.shadow_ranges		= rtw8852a_shadow_ranges,
+	.shadow_range_num	= ARRAY_SIZE(rtw8852a_shadow_ranges),
 	.pwr_on_seq		= pwr_on_seq_8852a,
 	.pwr_off_seq		= pwr_off_seq_8852a,
 	.bb_table		= &rtw89_8852a_phy_bb_table,
@@ -13,37 +13,49 @@
 #include "rtw8852a_table.h"
 
 static void
-_rfk_write_rf(struct rtw89_dev *rtwdev, const struct rtw89_reg5_def *def)
+_rfk_write_rf(struct rtw89_dev *rtwdev, struct rtw89_reg_batch *batch,
+	      const struct rtw89_reg5_def *def)
 {
+	rtw89_reg_batch_flush(rtwdev, batch);
 	rtw89_write_rf(rtwdev, def->path, def->addr, def->mask, def->data);
 }
 
 static void
-_rfk_write32_mask(struct rtw89_dev *rtwdev, const struct rtw89_reg5_def *def)
+_rfk_write32_mask(struct rtw89_dev *rtwdev, struct rtw89_reg_batch *batch,
+		  const struct rtw89_reg5_def *def)
 {
-	rtw89_phy_write32_mask(rtwdev, def->addr, def->mask, def->data);
+	rtw89_reg_batch_write32_mask(rtwdev, batch,
+				     def->addr | RTW89_PHY_ADDR_OFFSET,
+				     def->mask, def->data);
 }
 
 static void
-_rfk_write32_set(struct rtw89_dev *rtwdev, const struct rtw89_reg5_def *def)
+_rfk_write32_set(struct rtw89_dev *rtwdev, struct rtw89_reg_batch *batch,
+		 const struct rtw89_reg5_def *def)
 {
-	rtw89_phy_write32_set(rtwdev, def->addr, def->mask);
+	rtw89_reg_batch_write32_set(rtwdev, batch,
+				    def->addr | RTW89_PHY_ADDR_OFFSET, def->mask);
 }
 
 static void
-_rfk_write32_clr(struct rtw89_dev *rtwdev, const struct rtw89_reg5_def *def)
+_rfk_write32_clr(struct rtw89_dev *rtwdev, struct rtw89_reg_batch *batch,
+		 const struct rtw89_reg5_def *def)
 {
-	rtw89_phy_write32_clr(rtwdev, def->addr, def->mask);
+	rtw89_reg_batch_write32_clr(rtwdev, batch,
+				    def->addr | RTW89_PHY_ADDR_OFFSET, def->mask);
 }
 
 static void
-_rfk_delay(struct rtw89_dev *rtwdev, const struct rtw89_reg5_def *def)
+_rfk_delay(struct rtw89_dev *rtwdev, struct rtw89_reg_batch *batch,
+	   const struct rtw89_reg5_def *def)
 {
+	rtw89_reg_batch_flush(rtwdev, batch);
 	udelay(def->data);
 }
 
 static void
-(*_rfk_handler[])(struct rtw89_dev *rtwdev, const struct rtw89_reg5_def *def) = {
+(*_rfk_handler[])(struct rtw89_dev *rtwdev, struct rtw89_reg_batch *batch,
+		  const struct rtw89_reg5_def *def) = {
 	[RTW89_RFK_F_WRF] = _rfk_write_rf,
 	[RTW89_RFK_F_WM] = _rfk_write32_mask,
 	[RTW89_RFK_F_WS] = _rfk_write32_set,
@@ -58,9 +70,11 @@ rtw89_rfk_parser(struct rtw89_dev *rtwdev, const struct rtw89_rfk_tbl *tbl)
 {
 	const struct rtw89_reg5_def *p = tbl->defs;
 	const struct rtw89_reg5_def *end = tbl->defs + tbl->size;
+	struct rtw89_reg_batch batch = {};
 
 	for (; p < end; p++)
-		_rfk_handler[p->flag](rtwdev, p);
+		_rfk_handler[p->flag](rtwdev, &batch, p);
+	rtw89_reg_batch_flush(rtwdev, &batch);
 }
 
 #define rtw89_rfk_parser_by_cond(rtwdev, cond, tbl_t, tbl_f)	\
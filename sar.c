@@ -3,6 +3,7 @@
  */
 
 #include "debug.h"
+#include "phy.h"
 #include "sar.h"
 
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 11, 0)
@@ -36,6 +37,7 @@ struct rtw89_sar_handler rtw89_sar_handlers[RTW89_SAR_SOURCE_NR] = {
 		lockdep_assert_held(&_d->mutex);			\
 		_d->sar._cfg_name = *(_cfg_data);			\
 		_d->sar.src = _s;					\
+		rtw89_phy_txpwr_lmt_invalidate(_d);			\
 	} while (0)
 
 static s8 rtw89_txpwr_sar_to_mac(struct rtw89_dev *rtwdev, u8 fct, s32 cfg)
@@ -0,0 +1,393 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0 OR BSD-3-Clause
+#
+# Pack the PHY register and TX power limit tables of a rtw89 table source.
+#
+#   table_pack.py pack rtw8852a_table.c -o rtw8852a_table_packed.c
+#   table_pack.py blob rtw8852a_table.c -o rtw8852a_table.bin --version N
+#
+# The vendor table source stays as it is in the tree; the Makefile runs pack
+# to generate the file that is built into rtw89core. blob writes the same
+# packed tables to a blob that the driver loads from the firmware directory
+# in place of the compiled-in ones (see struct rtw89_tbl_blob_hdr).
+#
+# Register tables become a byte stream decoded by rtw89_phy_table_next().
+# Each entry starts with a tag byte:
+#
+#   0xc0 | n          condition entry n of the table's dictionary
+#   (amode << 6) | d  register write
+#
+#   amode 0: same address as the previous write
+#   amode 1: previous address + stride
+#   amode 2: previous address + stride * zigzag varint that follows
+#   d 0x00..0x3a: data is d
+#   d 0x3b..0x3e: data is the next 1..4 bytes, little endian
+#   d 0x3f:       data of the previous write
+#
+# Limit tables keep every distinct per-channel row once in a pool, and a u8
+# pool index per row; row 0 of the pool is all zeroes.
+
+import argparse
+import math
+import os
+import re
+import struct
+import sys
+import zlib
+
+REG_ARRAY = re.compile(
+    r'static const struct rtw89_reg2_def (\w+)\[\] = \{\n(.*?)\n\};\n',
+    re.S)
+REG_ENTRY = re.compile(r'\{(0x[0-9A-Fa-f]+),\s*(0x[0-9A-Fa-f]+)\}')
+TABLE_REGS = re.compile(r'\t\.regs\t\t= (\w+),\n\t\.n_regs\t\t= ARRAY_SIZE\(\1\),\n')
+
+LMT_ARRAY = re.compile(
+    r'const s8 (\w+)((?:\[\w+\]\s*)+) = \{\n(.*?)\n\};\n', re.S)
+LMT_ENTRY = re.compile(r'((?:\[\w+\])+) = (-?\d+),')
+
+BLOB_MAGIC = 0x54393852
+BLOB_FORMAT = 1
+BLOB_HDR = struct.Struct('<IBBHIII')
+BLOB_ENT = struct.Struct('<BBBBIII')
+BLOB_ID = {'bb': 0, 'nctl': 1, 'radioa': 2, 'radiob': 3, 'radioc': 4,
+           'radiod': 5, 'txpwr_lmt_2g': 6, 'txpwr_lmt_5g': 7,
+           'txpwr_lmt_ru_2g': 8, 'txpwr_lmt_ru_5g': 9}
+
+COND_SHIFT = 28
+TAG_COND = 0xc0
+DATA_LIT_MAX = 0x3a
+DATA_PREV = 0x3f
+
+
+def parse_regd(core_h):
+    body = re.search(r'enum rtw89_regulation_type \{(.*?)\};', core_h, re.S)
+    regd = {}
+    for name, val in re.findall(r'(RTW89_\w+)\s*=\s*(\d+)', body.group(1)):
+        regd[name] = int(val)
+    return regd
+
+
+def parse_dims(core_h):
+    defs = dict(re.findall(r'#define (RTW89_\w+_NUM) (\d+)\n', core_h))
+    dims = {k: int(v) for k, v in defs.items()}
+    dims['RTW89_2G_BW_NUM'] = 2
+    dims['RTW89_5G_BW_NUM'] = 3
+    dims['RTW89_NTX_NUM'] = 2
+    dims['RTW89_RS_LMT_NUM'] = 3
+    dims['RTW89_BF_NUM'] = 2
+    dims['RTW89_RU_NUM'] = 3
+    dims['RTW89_REGD_NUM'] = len(parse_regd(core_h))
+    return dims
+
+
+def varint(val):
+    out = bytearray()
+    while True:
+        byte = val & 0x7f
+        val >>= 7
+        if not val:
+            out.append(byte)
+            return out
+        out.append(byte | 0x80)
+
+
+def read_varint(data, pos):
+    val = shift = 0
+    while True:
+        byte = data[pos]
+        pos += 1
+        val |= (byte & 0x7f) << shift
+        shift += 7
+        if not byte & 0x80:
+            return val, pos
+
+
+def zigzag(val):
+    return val << 1 if val >= 0 else ((-val) << 1) - 1
+
+
+def unzigzag(val):
+    return (val >> 1) ^ -(val & 1)
+
+
+def table_stride(regs):
+    stride = 0
+    prev = 0
+    for addr, _ in regs:
+        if addr >> COND_SHIFT:
+            continue
+        stride = math.gcd(stride, abs(addr - prev))
+        prev = addr
+    return stride or 1
+
+
+def encode_regs(regs):
+    stride = table_stride(regs)
+    conds = []
+    out = bytearray()
+    prev_addr = prev_data = 0
+
+    for addr, data in regs:
+        if addr >> COND_SHIFT:
+            if (addr, data) not in conds:
+                conds.append((addr, data))
+            idx = conds.index((addr, data))
+            if idx > 0xff - TAG_COND:
+                sys.exit('too many condition entries')
+            out.append(TAG_COND | idx)
+            continue
+
+        extra = b''
+        if addr == prev_addr:
+            amode = 0
+        elif addr == prev_addr + stride:
+            amode = 1
+        else:
+            amode = 2
+            extra = varint(zigzag((addr - prev_addr) // stride))
+
+        if data <= DATA_LIT_MAX:
+            dmode = data
+        elif data == prev_data:
+            dmode = DATA_PREV
+        else:
+            n = (data.bit_length() + 7) // 8
+            dmode = DATA_LIT_MAX + n
+            extra += data.to_bytes(n, 'little')
+
+        out.append(amode << 6 | dmode)
+        out += extra
+        prev_addr = addr
+        prev_data = data
+
+    return out, conds, stride
+
+
+def decode_regs(data, conds, stride, n_regs):
+    regs = []
+    pos = 0
+    addr = prev = 0
+
+    while len(regs) < n_regs:
+        tag = data[pos]
+        pos += 1
+        if tag >= TAG_COND:
+            regs.append(conds[tag - TAG_COND])
+            continue
+
+        amode = tag >> 6
+        if amode == 1:
+            addr += stride
+        elif amode == 2:
+            delta, pos = read_varint(data, pos)
+            addr += unzigzag(delta) * stride
+
+        dmode = tag & 0x3f
+        if dmode <= DATA_LIT_MAX:
+            val = dmode
+        elif dmode == DATA_PREV:
+            val = prev
+        else:
+            n = dmode - DATA_LIT_MAX
+            val = int.from_bytes(data[pos:pos + n], 'little')
+            pos += n
+
+        regs.append((addr, val))
+        prev = val
+
+    if pos != len(data):
+        sys.exit('trailing bytes in packed table')
+    return regs
+
+
+def c_bytes(data, per_line=12):
+    lines = []
+    for i in range(0, len(data), per_line):
+        chunk = data[i:i + per_line]
+        lines.append('\t' + ' '.join('0x%02x,' % b for b in chunk))
+    return '\n'.join(lines)
+
+
+def c_regs(regs):
+    return '\n'.join('\t{0x%x, 0x%08x},' % (a, d) for a, d in regs)
+
+
+def base_name(name):
+    return name[:-len('_regs')] if name.endswith('_regs') else name
+
+
+def blob_id(name):
+    for kind, tbl_id in BLOB_ID.items():
+        if name.endswith('_' + kind):
+            return tbl_id
+    sys.exit('%s: unknown table kind' % name)
+
+
+def pack_regs(src, tables, stats):
+    names = set(TABLE_REGS.findall(src))
+
+    def repl(m):
+        name = m.group(1)
+        if name not in names:
+            return m.group(0)
+        regs = [(int(a, 16), int(d, 16)) for a, d in REG_ENTRY.findall(m.group(2))]
+        data, conds, stride = encode_regs(regs)
+        if decode_regs(data, conds, stride, len(regs)) != regs:
+            sys.exit('%s: packed table does not decode back' % name)
+        base = base_name(name)
+        stats.append((name, len(regs) * 8, len(data) + len(conds) * 8))
+        raw = b''.join(struct.pack('<II', a, d) for a, d in conds)
+        tables.append((blob_id(base), stride, len(conds), len(regs),
+                       raw + data))
+        conds_src = '\n%s\n' % c_regs(conds) if conds else ''
+        return ('static const struct rtw89_reg2_def %s_conds[] = {%s};\n\n'
+                'static const u8 %s_data[] = {\n%s\n};\n\n'
+                'static const struct rtw89_phy_packed_table %s_packed = {\n'
+                '\t.data\t\t= %s_data,\n'
+                '\t.len\t\t= ARRAY_SIZE(%s_data),\n'
+                '\t.conds\t\t= %s_conds,\n'
+                '\t.n_conds\t= ARRAY_SIZE(%s_conds),\n'
+                '\t.n_regs\t\t= %d,\n'
+                '\t.stride\t\t= %d,\n'
+                '};\n' % (base, conds_src, base, c_bytes(data), base,
+                          base, base, base, base, len(regs), stride))
+
+    src = REG_ARRAY.sub(repl, src)
+    return TABLE_REGS.sub(lambda m: '\t.packed\t\t= &%s_packed,\n' %
+                          base_name(m.group(1)), src)
+
+
+def pack_lmt(src, regd, dims, tables, stats):
+    def repl(m):
+        name, dims_src, body = m.groups()
+        dim_names = re.findall(r'\[(\w+)\]', dims_src)
+        if dim_names[-2] != 'RTW89_REGD_NUM':
+            return m.group(0)
+        sizes = [dims[d] for d in dim_names]
+        ch_num = sizes[-1]
+        n_rows = math.prod(sizes[:-1])
+        rows = [[0] * ch_num for _ in range(n_rows)]
+
+        for idx_src, val in LMT_ENTRY.findall(body):
+            idx = [regd[i] if i in regd else int(i)
+                   for i in re.findall(r'\[(\w+)\]', idx_src)]
+            row = 0
+            for i, size in zip(idx[:-1], sizes[:-1]):
+                row = row * size + i
+            rows[row][idx[-1]] = int(val)
+
+        pool = [tuple([0] * ch_num)]
+        index = []
+        for row in rows:
+            row = tuple(row)
+            if row not in pool:
+                pool.append(row)
+            index.append(pool.index(row))
+        if len(pool) > 0x100:
+            sys.exit('%s: too many distinct rows' % name)
+
+        stats.append((name, n_rows * ch_num, n_rows + len(pool) * ch_num))
+        tables.append((blob_id(name), ch_num, 0, n_rows,
+                       bytes(index) + bytes(v & 0xff for row in pool
+                                            for v in row)))
+        pool_src = '\n'.join('\t{%s},' % ', '.join(str(v) for v in row)
+                             for row in pool)
+        return ('static const u8 %s_rows[] = {\n%s\n};\n\n'
+                'static const s8 %s_pool[][%s] = {\n%s\n};\n\n'
+                'static_assert(ARRAY_SIZE(%s_rows) ==\n\t      %s);\n\n'
+                'const struct rtw89_txpwr_lmt_dict %s = {\n'
+                '\t.rows\t\t= %s_rows,\n'
+                '\t.pool\t\t= &%s_pool[0][0],\n'
+                '\t.ch_num\t\t= %s,\n'
+                '};\n' % (name, c_bytes(index), name, dim_names[-1],
+                          pool_src, name, ' * '.join(dim_names[:-1]), name,
+                          name, name, dim_names[-1]))
+
+    return LMT_ARRAY.sub(repl, src)
+
+
+def parse_chip_id(core_h, chip):
+    body = re.search(r'enum rtw89_core_chip_id \{(.*?)\};', core_h, re.S)
+    names = re.findall(r'(\w+),', body.group(1))
+    if chip not in names:
+        sys.exit('unknown chip %s' % chip)
+    return names.index(chip)
+
+
+def make_blob(tables, chip_id, version):
+    if not tables:
+        sys.exit('no tables to pack')
+
+    off = BLOB_HDR.size + BLOB_ENT.size * len(tables)
+    ents = b''
+    body = b''
+    for tbl_id, arg, n_conds, n_items, data in sorted(tables):
+        body += bytes(-(off + len(body)) % 4)
+        ents += BLOB_ENT.pack(tbl_id, arg, n_conds, 0, n_items,
+                              off + len(body), len(data))
+        body += data
+
+    rest = ents + body
+    hdr = BLOB_HDR.pack(BLOB_MAGIC, BLOB_FORMAT, chip_id, len(tables),
+                        version, BLOB_HDR.size + len(rest), zlib.crc32(rest))
+    return hdr + rest
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Pack rtw89 PHY tables')
+    parser.add_argument('cmd', choices=['pack', 'blob'])
+    parser.add_argument('path', help='vendor table source, e.g. rtw8852a_table.c')
+    parser.add_argument('-o', '--output', help='file to write')
+    parser.add_argument('--core-h', default='core.h',
+                        help='core.h for enum values (default: %(default)s)')
+    parser.add_argument('--version', type=int, default=0,
+                        help='table version stored in the blob')
+    parser.add_argument('--chip',
+                        help='chip of the blob (default: from the file name)')
+    parser.add_argument('-v', '--verbose', action='store_true',
+                        help='print the size of every table')
+    args = parser.parse_args()
+
+    with open(args.core_h) as f:
+        core_h = f.read()
+    regd = parse_regd(core_h)
+    dims = parse_dims(core_h)
+
+    with open(args.path) as f:
+        src = f.read()
+
+    tables = []
+    stats = []
+    src = pack_regs(src, tables, stats)
+    src = pack_lmt(src, regd, dims, tables, stats)
+
+    if args.cmd == 'pack':
+        name = os.path.basename(args.path)
+        src = src.replace('\n\n', '\n/* Generated from %s by table_pack.py, do not edit. */\n\n'
+                          % name, 1)
+        with open(args.output or args.path.replace('.c', '_packed.c'), 'w') as f:
+            f.write(src)
+    else:
+        chip = args.chip
+        if not chip:
+            m = re.match(r'rtw(\w+?)_', os.path.basename(args.path))
+            chip = 'RTL' + m.group(1).upper()
+        blob = make_blob(tables, parse_chip_id(core_h, chip), args.version)
+        with open(args.output or args.path.replace('.c', '.bin'), 'wb') as f:
+            f.write(blob)
+        print('%u bytes, %s version %u' % (len(blob), chip, args.version))
+
+    if not args.verbose:
+        return
+    for name, raw, packed in stats:
+        print('%-32s %7u -> %6u bytes (%.1f%%)' %
+              (name, raw, packed, 100.0 * packed / raw))
+    if stats:
+        raw = sum(s[1] for s in stats)
+        packed = sum(s[2] for s in stats)
+        print('%-32s %7u -> %6u bytes (%.1f%%)' %
+              ('total', raw, packed, 100.0 * packed / raw))
+
+
+if __name__ == '__main__':
+    main()
@@ -304,6 +304,23 @@ static inline u8 rtw89_core_get_ch_dma(struct rtw89_dev *rtwdev, u8 qsel)
 	}
 }
 
+static inline u8 rtw89_core_get_ac_by_ch_dma(u8 ch_dma)
+{
+	switch (ch_dma) {
+	case RTW89_TXCH_ACH0:
+		return IEEE80211_AC_BE;
+	case RTW89_TXCH_ACH1:
+		return IEEE80211_AC_BK;
+	case RTW89_TXCH_ACH2:
+		return IEEE80211_AC_VI;
+	case RTW89_TXCH_ACH3:
+		return IEEE80211_AC_VO;
+	default:
+		/* not backed by a mac80211 queue */
+		return IEEE80211_NUM_ACS;
+	}
+}
+
 static inline u8 rtw89_core_get_tid_indicate(struct rtw89_dev *rtwdev, u8 tid)
 {
 	switch (tid) {